@@ -43,6 +43,8 @@
 
 #include "client.h"
 #include "iconimageprovider.h"
+#include "thumbnailprovider.h"
+#include "wallpaperprovider.h"
 #include "window.h"
 #include "shellui.h"
 #include "element.h"
@@ -54,6 +56,7 @@
 #include "notification.h"
 #include "activeregion.h"
 #include "clipboard.h"
+#include "windowthumbnail.h"
 
 Client *Client::s_client = nullptr;
 
@@ -94,6 +97,8 @@ Binding::~Binding()
 Client::Client()
       : QObject()
       , m_notifications(nullptr)
+      , m_shm(nullptr)
+      , m_clipboard(nullptr)
       , m_ui(nullptr)
       , d_ptr(new ClientPrivate(this))
 {
@@ -116,6 +121,8 @@ Client::Client()
     qmlRegisterType<Style>("Orbital", 1, 0, "Style");
     qmlRegisterType<NotificationWindow>("Orbital", 1, 0, "NotificationWindow");
     qmlRegisterType<ActiveRegion>("Orbital", 1, 0, "ActiveRegion");
+    qmlRegisterType<WindowThumbnail>("Orbital", 1, 0, "WindowThumbnail");
+    qmlRegisterType<ClipboardHistory>("Orbital", 1, 0, "ClipboardHistory");
     qmlRegisterUncreatableType<Window>("Orbital", 1, 0, "Window", QStringLiteral("Cannot create Window"));
     qmlRegisterUncreatableType<Workspace>("Orbital", 1, 0, "Workspace", QStringLiteral("Cannot create Workspace"));
     qmlRegisterUncreatableType<ElementInfo>("Orbital", 1, 0, "ElementInfo", QStringLiteral("ElementInfo is not creatable"));
@@ -150,6 +157,8 @@ Client::Client()
     m_engine = new QQmlEngine(this);
     m_engine->rootContext()->setContextProperty(QStringLiteral("Client"), this);
     m_engine->addImageProvider(QStringLiteral("icon"), new IconImageProvider);
+    m_engine->addImageProvider(QStringLiteral("thumbnail"), new ThumbnailProvider);
+    m_engine->addImageProvider(QStringLiteral("wallpaper"), new WallpaperProvider);
     m_engine->addImportPath(QStringLiteral(LIBRARIES_PATH "/qml"));
 
     // TODO: find a way to un-hardcode this
@@ -376,6 +385,27 @@ void Client::quit()
     desktop_shell_quit(m_shell);
 }
 
+void Client::endSession(int timeout, const std::function<void ()> &callback)
+{
+    static const wl_callback_listener listener = {
+        [](void *data, wl_callback *cb, uint32_t) {
+            auto *func = static_cast<std::function<void ()> *>(data);
+            (*func)();
+            delete func;
+            wl_callback_destroy(cb);
+        }
+    };
+
+    // an older compositor cannot do it, just go on
+    if (wl_proxy_get_version((wl_proxy *)m_shell) < DESKTOP_SHELL_END_SESSION_SINCE_VERSION) {
+        callback();
+        return;
+    }
+
+    wl_callback *cb = desktop_shell_end_session(m_shell, timeout);
+    wl_callback_add_listener(cb, &listener, new std::function<void ()>(callback));
+}
+
 void Client::lockSession()
 {
     desktop_shell_lock(m_shell);
@@ -468,18 +498,18 @@ wl_subsurface *Client::getSubsurface(QQuickWindow *window, QQuickWindow *parent)
 
 void Client::handleGlobal(wl_registry *registry, uint32_t id, const char *interface, uint32_t version)
 {
-    Q_UNUSED(version);
-
     if (strcmp(interface, "desktop_shell") == 0) {
         // Bind interface and register listener
-        m_shell = static_cast<desktop_shell *>(wl_registry_bind(registry, id, &desktop_shell_interface, version));
+        m_shell = static_cast<desktop_shell *>(wl_registry_bind(registry, id, &desktop_shell_interface, qMin(version, 2u)));
         desktop_shell_add_listener(m_shell, &s_shellListener, this);
     } else if (strcmp(interface, "notifications_manager") == 0) {
         m_notifications = static_cast<notifications_manager *>(wl_registry_bind(registry, id, &notifications_manager_interface, 1));
     } else if (strcmp(interface, "wl_subcompositor") == 0) {
         m_subcompositor = static_cast<wl_subcompositor *>(wl_registry_bind(registry, id, &wl_subcompositor_interface, 1));
+    } else if (strcmp(interface, "wl_shm") == 0) {
+        m_shm = static_cast<wl_shm *>(wl_registry_bind(registry, id, &wl_shm_interface, 1));
     } else if (strcmp(interface, "orbital_clipboard_manager") == 0) {
-        wl_registry_bind(registry, id, &orbital_clipboard_manager_interface, 1);
+        m_clipboard = static_cast<orbital_clipboard_manager *>(wl_registry_bind(registry, id, &orbital_clipboard_manager_interface, 1));
     }
 }
 
@@ -40,6 +40,7 @@ struct wl_output;
 struct wl_subcompositor;
 struct wl_subsurface;
 struct wl_seat;
+struct wl_shm;
 
 struct desktop_shell;
 struct desktop_shell_listener;
@@ -52,6 +53,7 @@ struct notifications_manager;
 struct notification_surface;
 struct active_region;
 struct orbital_compositor_action;
+struct orbital_clipboard_manager;
 
 class Window;
 class ShellUI;
@@ -86,6 +88,11 @@ public:
     ~Client();
 
     void quit();
+    /**
+     * Ask all the other clients to quit, calling the callback when they are gone,
+     * or after timeout milliseconds.
+     */
+    void endSession(int timeout, const std::function<void ()> &callback);
     void lockSession();
     void unlockSession();
     bool isSessionLocked() const;
@@ -108,6 +115,8 @@ public:
     notification_surface *pushNotification(QWindow *window, bool inactive);
     active_region *createActiveRegion(QQuickWindow *window, const QRect &rect);
     wl_subsurface *getSubsurface(QQuickWindow *window, QQuickWindow *parent);
+    inline wl_shm *shm() const { return m_shm; }
+    inline orbital_clipboard_manager *clipboardManager() const { return m_clipboard; }
     void addOverlay(QQuickWindow *window, QScreen *screen);
     void setInputRegion(QQuickWindow *w, const QRectF &region);
     QProcess *createTrustedClient(const QString &interface);
@@ -170,6 +179,8 @@ private:
     desktop_shell *m_shell;
     notifications_manager *m_notifications;
     wl_subcompositor *m_subcompositor;
+    wl_shm *m_shm;
+    orbital_clipboard_manager *m_clipboard;
     QQmlEngine *m_engine;
     QWindow *m_grabWindow;
     QList<Binding *> m_bindings;
@@ -22,6 +22,10 @@
 #include <QDebug>
 
 #include "clipboard.h"
+#include "client.h"
+#include "utils.h"
+
+#include "wayland-clipboard-client-protocol.h"
 
 Clipboard::Clipboard(QObject *p)
          : QObject(p)
@@ -44,3 +48,178 @@ Clipboard *Clipboard::qmlAttachedProperties(QObject *obj)
 {
     return new Clipboard(obj);
 }
+
+
+// fetch the history a page at a time, the views ask for more when scrolling
+static const int PageSize = 20;
+
+const orbital_clipboard_history_listener ClipboardHistory::s_listener = {
+    wrapInterface(&ClipboardHistory::handleEntry),
+    wrapInterface(&ClipboardHistory::handleListed),
+    wrapInterface(&ClipboardHistory::handleEntryAdded),
+    wrapInterface(&ClipboardHistory::handleEntryRemoved),
+    wrapInterface(&ClipboardHistory::handleCurrent)
+};
+
+ClipboardHistory::ClipboardHistory(QObject *p)
+                : QAbstractListModel(p)
+                , m_history(nullptr)
+                , m_total(-1)
+                , m_listing(false)
+                , m_current(0)
+{
+    orbital_clipboard_manager *manager = Client::client()->clipboardManager();
+    if (manager) {
+        m_history = orbital_clipboard_manager_get_history(manager);
+        orbital_clipboard_history_add_listener(m_history, &s_listener, this);
+    }
+}
+
+ClipboardHistory::~ClipboardHistory()
+{
+    if (m_history) {
+        orbital_clipboard_history_destroy(m_history);
+    }
+}
+
+int ClipboardHistory::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.count();
+}
+
+QVariant ClipboardHistory::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_entries.count()) {
+        return QVariant();
+    }
+
+    const Entry &e = m_entries.at(index.row());
+    switch (role) {
+        case TextRole: return e.text;
+        case EntryIdRole: return e.id;
+        case MimeTypeRole: return e.mimeType;
+        case SizeRole: return e.size;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> ClipboardHistory::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[TextRole] = "text";
+    roles[EntryIdRole] = "entryId";
+    roles[MimeTypeRole] = "mimeType";
+    roles[SizeRole] = "size";
+    return roles;
+}
+
+bool ClipboardHistory::canFetchMore(const QModelIndex &parent) const
+{
+    return m_history && !parent.isValid() && !m_listing && (m_total < 0 || m_entries.count() < m_total);
+}
+
+void ClipboardHistory::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+
+    m_listing = true;
+    orbital_clipboard_history_list(m_history, m_entries.count(), PageSize);
+}
+
+int ClipboardHistory::indexOf(uint32_t id) const
+{
+    for (int i = 0; i < m_entries.count(); ++i) {
+        if (m_entries.at(i).id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int ClipboardHistory::current() const
+{
+    return m_current ? indexOf(m_current) : -1;
+}
+
+QString ClipboardHistory::currentText() const
+{
+    int i = current();
+    return i > -1 ? m_entries.at(i).text : QString();
+}
+
+void ClipboardHistory::activate(int index)
+{
+    if (index >= 0 && index < m_entries.count()) {
+        orbital_clipboard_history_activate(m_history, m_entries.at(index).id);
+    }
+}
+
+void ClipboardHistory::remove(int index)
+{
+    if (index >= 0 && index < m_entries.count()) {
+        orbital_clipboard_history_remove(m_history, m_entries.at(index).id);
+    }
+}
+
+void ClipboardHistory::handleEntry(orbital_clipboard_history *h, uint32_t id, const char *preview, const char *mimeType, uint32_t size)
+{
+    // entries added while listing shift the ones after them, so we may get one twice
+    if (indexOf(id) > -1) {
+        return;
+    }
+
+    int row = m_entries.count();
+    beginInsertRows(QModelIndex(), row, row);
+    m_entries << Entry{ id, QString::fromUtf8(preview), QString::fromUtf8(mimeType), size };
+    endInsertRows();
+    if (id == m_current) {
+        emit currentChanged();
+    }
+}
+
+void ClipboardHistory::handleListed(orbital_clipboard_history *h, uint32_t total)
+{
+    m_total = total;
+    m_listing = false;
+}
+
+void ClipboardHistory::handleEntryAdded(orbital_clipboard_history *h, uint32_t id, const char *preview, const char *mimeType, uint32_t size)
+{
+    beginInsertRows(QModelIndex(), 0, 0);
+    m_entries.prepend(Entry{ id, QString::fromUtf8(preview), QString::fromUtf8(mimeType), size });
+    endInsertRows();
+    if (m_total > -1) {
+        ++m_total;
+    }
+    // the current entry moved down one row
+    if (m_current) {
+        emit currentChanged();
+    }
+}
+
+void ClipboardHistory::handleEntryRemoved(orbital_clipboard_history *h, uint32_t id)
+{
+    if (m_total > 0) {
+        --m_total;
+    }
+
+    int i = indexOf(id);
+    if (i < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), i, i);
+    m_entries.removeAt(i);
+    endRemoveRows();
+    if (m_current) {
+        emit currentChanged();
+    }
+}
+
+void ClipboardHistory::handleCurrent(orbital_clipboard_history *h, uint32_t id)
+{
+    m_current = id;
+    emit currentChanged();
+}
@@ -21,8 +21,12 @@
 #define ORBITAL_CLIPBOARD_H
 
 #include <QObject>
+#include <QAbstractListModel>
 #include <QtQml>
 
+struct orbital_clipboard_history;
+struct orbital_clipboard_history_listener;
+
 class Clipboard : public QObject
 {
     Q_OBJECT
@@ -40,6 +44,61 @@ signals:
 
 };
 
+class ClipboardHistory : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int current READ current NOTIFY currentChanged)
+    Q_PROPERTY(QString currentText READ currentText NOTIFY currentChanged)
+public:
+    enum Roles {
+        TextRole = Qt::UserRole + 1,
+        EntryIdRole,
+        MimeTypeRole,
+        SizeRole
+    };
+
+    ClipboardHistory(QObject *p = nullptr);
+    ~ClipboardHistory();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    int current() const;
+    QString currentText() const;
+
+    Q_INVOKABLE void activate(int index);
+    Q_INVOKABLE void remove(int index);
+
+signals:
+    void currentChanged();
+
+private:
+    struct Entry {
+        uint32_t id;
+        QString text;
+        QString mimeType;
+        uint32_t size;
+    };
+
+    int indexOf(uint32_t id) const;
+    void handleEntry(orbital_clipboard_history *h, uint32_t id, const char *preview, const char *mimeType, uint32_t size);
+    void handleListed(orbital_clipboard_history *h, uint32_t total);
+    void handleEntryAdded(orbital_clipboard_history *h, uint32_t id, const char *preview, const char *mimeType, uint32_t size);
+    void handleEntryRemoved(orbital_clipboard_history *h, uint32_t id);
+    void handleCurrent(orbital_clipboard_history *h, uint32_t id);
+
+    orbital_clipboard_history *m_history;
+    QList<Entry> m_entries;
+    int m_total;
+    bool m_listing;
+    uint32_t m_current;
+
+    static const orbital_clipboard_history_listener s_listener;
+};
+
 QML_DECLARE_TYPE(Clipboard)
 QML_DECLARE_TYPEINFO(Clipboard, QML_HAS_ATTACHED_PROPERTIES)
 
@@ -28,6 +28,7 @@
 #include "uiscreen.h"
 #include "styleitem.h"
 #include "panel.h"
+#include "manifestindex.h"
 
 static const int a = qmlRegisterType<Element>("Orbital", 1, 0, "ElementBase");
 static const int b = qmlRegisterType<ElementConfig>("Orbital", 1, 0, "ElementConfig");
@@ -373,8 +374,8 @@ void Element::createBackground(Element *child)
 
 void Element::settingsVisibleChanged(bool visible)
 {
-    if (!visible) {
-        m_shell->saveConfig();
+    if (!visible && m_screen) {
+        m_shell->screenConfigChanged(m_screen);
     }
 }
 
@@ -425,18 +426,13 @@ Element *Element::create(ShellUI *shell, UiScreen *screen, QQmlEngine *engine, c
 
 void Element::loadElementsList()
 {
-    auto checkPath = [](const QString &path) {
-        QDir dir(QUrl(path).toString(QUrl::NormalizePathSegments));
-        const QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-        for (const QString &subdir: subdirs) {
-            dir.cd(subdir);
-            if (dir.exists(QStringLiteral("element"))) {
-                if (!s_elements.contains(subdir)) {
-                    loadElementInfo(subdir, dir.absolutePath());
-                }
+    ManifestIndex index(QStringLiteral("elements"), QStringLiteral("element"));
+    auto checkPath = [&index](const QString &path) {
+        index.scan(path, [](const QString &name, const QString &elementPath, const QJsonObject &json) {
+            if (!s_elements.contains(name)) {
+                loadElementInfo(name, elementPath, json);
             }
-            dir.cdUp();
-        }
+        });
     };
 
     checkPath(QLatin1String(DATA_PATH "/elements"));
@@ -454,33 +450,14 @@ void Element::cleanupElementsList()
     }
 }
 
-void Element::loadElementInfo(const QString &name, const QString &path)
+void Element::loadElementInfo(const QString &name, const QString &path, const QJsonObject &json)
 {
-    QString filePath(path + QLatin1String("/element"));
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << QStringLiteral("Failed to load the element '%1'. Could not open %1 for reading.").arg(filePath);
-        return;
-    }
-
     ElementInfo *info = new ElementInfo;
     info->m_name = name;
     info->m_path = path;
     info->m_prettyName = name;
     info->m_type = ElementInfo::Type::Item;
 
-    QByteArray data = file.readAll();
-    file.close();
-
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError) {
-        qWarning("Error parsing %s at offset %d: %s", qPrintable(filePath), error.offset, qPrintable(error.errorString()));
-        delete info;
-        return;
-    }
-    QJsonObject json = doc.object();
-
     info->m_prettyName = json.value(QStringLiteral("prettyName")).toString();
     if (json.contains(QStringLiteral("qmlFile"))) {
         info->m_qml = path + QLatin1Char('/') + json.value(QStringLiteral("qmlFile")).toString();
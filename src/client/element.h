@@ -29,6 +29,7 @@ class QQuickWindow;
 struct wl_surface;
 
 class LayoutAttached;
+class QJsonObject;
 class ElementConfig;
 class ShellUI;
 class UiScreen;
@@ -81,6 +82,7 @@ class Element : public QQuickItem
     Q_PROPERTY(Location location READ location NOTIFY locationChanged)
     Q_PROPERTY(UiScreen *screen READ screen NOTIFY screenChanged);
     Q_PROPERTY(QString prettyName READ prettyName CONSTANT);
+    Q_PROPERTY(int elementId READ elementId CONSTANT)
     Q_CLASSINFO("DefaultProperty", "resources")
 public:
     enum class Location {
@@ -96,6 +98,7 @@ public:
     ~Element();
 
     inline ElementInfo::Type type() const { return m_info->type(); }
+    inline int elementId() const { return m_id; }
 
     Q_INVOKABLE void addProperty(const QString &name);
     Q_INVOKABLE void destroyElement();
@@ -182,7 +185,7 @@ private:
     void createBackground(Element *child);
     void settingsVisibleChanged(bool visible);
 
-    static void loadElementInfo(const QString &name, const QString &path);
+    static void loadElementInfo(const QString &name, const QString &path, const QJsonObject &json);
 
     QString m_typeName;
     ElementInfo *m_info;
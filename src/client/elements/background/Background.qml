@@ -161,7 +161,10 @@ Element {
 
         Image {
             id: image
-            source: bkg.imageSource
+            // the image comes already scaled for the fill mode, shared with the other screens.
+            // the element id lets the provider drop the wallpapers no background uses anymore
+            source: bkg.imageSource ? "image://wallpaper/" + bkg.elementId + "/" + fillMode + "/" + encodeURIComponent(bkg.imageSource) : ""
+            sourceSize: Qt.size(width, height)
             fillMode: bkg.fillModes[bkg.imageFillMode].value
             anchors.fill: parent
             smooth: true
@@ -293,7 +296,7 @@ Element {
                             }
                         }
 
-                        model: browser.dirContent
+                        model: browser
                         orientation: ListView.Horizontal
 
                         delegate: Rectangle {
@@ -314,15 +317,14 @@ Element {
                                     sourceSize: Qt.size(width, height)
                                     fillMode: Image.PreserveAspectFit
                                     asynchronous: true
-                                    cache: modelData.isDir()
 
-                                    source: modelData.isDir() ? "image://icon/folder" : modelData.path()
+                                    source: model.isDir ? "image://icon/folder" : "image://thumbnail/" + encodeURIComponent(model.path)
                                 }
                                 Text {
                                     anchors.top: thumb.bottom
                                     width: parent.width
                                     horizontalAlignment: Text.AlignHCenter
-                                    text: modelData.name
+                                    text: model.name
                                     color: "white"
                                     elide: Text.ElideMiddle
                                 }
@@ -349,10 +351,10 @@ Element {
                                 onExited: glow.opacity = 0
 
                                 onClicked: {
-                                    if (modelData.isDir()) {
-                                        browser.cd(modelData.name);
+                                    if (model.isDir) {
+                                        browser.cd(model.name);
                                     } else {
-                                        bkg.imageSource = modelData.path();
+                                        bkg.imageSource = model.path;
                                     }
                                 }
                             }
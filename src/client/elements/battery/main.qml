@@ -53,8 +53,7 @@ Element {
 
             Connections {
                 target: modelData
-                onChargeStateChanged: battery.updateTooltipText()
-                onRemainingTimeChanged: battery.updateTooltipText()
+                onChanged: battery.updateTooltipText()
             }
 
             function updateTooltipText() {
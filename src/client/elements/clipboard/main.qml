@@ -33,7 +33,6 @@ PopupElement {
     Layout.preferredHeight: 30
     minimumWidth: 40
     minimumHeight: 40
-    property int selectionActive: -1
 
     buttonContent: Icon {
         id: icon
@@ -44,40 +43,14 @@ PopupElement {
 
     }
 
-    Clipboard.onTextChanged: {
-        var curr = historyModel.count > 0 ? historyModel.get(0).text : ""
-        var text = Clipboard.text;
-        if (!text) {
-            selectionActive = -1;
-            return;
-        }
-        selectionActive = 0;
-        if (text == curr) {
-            return;
-        }
-
-        for (var i = 0; i < historyModel.count; ++i) {
-            if (historyModel.get(i).text == text) {
-                historyModel.remove(i);
-                break;
-            }
-        }
-
-        historyModel.insert(0, { "text": text });
-        if (historyModel.count > 15) {
-            historyModel.remove(14);
-        }
-    }
-
     function activate(index) {
-        if (index == selectionActive) {
+        if (index == historyModel.current) {
             return;
         }
-        var text = historyModel.get(index).text;
-        Clipboard.text = text
+        historyModel.activate(index);
     }
 
-    ListModel {
+    ClipboardHistory {
         id: historyModel
     }
 
@@ -162,7 +135,7 @@ PopupElement {
                     x: 2
                     y: 2
                     width: parent.width - 4
-                    text: modelData
+                    text: model.text
                     elide: Text.ElideRight
                     wrapMode: Text.WrapAnywhere
                     color: CurrentStyle.textColor
@@ -174,7 +147,7 @@ PopupElement {
                     anchors.verticalCenter: parent.verticalCenter
                     anchors.margins: 2
                     source: "image://icon/edit-paste"
-                    opacity: index == root.selectionActive
+                    opacity: index == historyModel.current
                     fillMode: Image.PreserveAspectFit
                     sourceSize: Qt.size(32, 32)
                     Behavior on opacity { PropertyAnimation {} }
@@ -197,7 +170,7 @@ PopupElement {
         horizontalAlignment: Qt.AlignHCenter
         verticalAlignment: Qt.AlignVCenter
         color: CurrentStyle.textColor
-        text: Clipboard.text || "No selection"
+        text: historyModel.currentText || "No selection"
         elide: Text.ElideRight
         wrapMode: Text.Wrap
     }
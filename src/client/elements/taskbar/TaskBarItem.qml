@@ -106,10 +106,15 @@ Item {
 
     property string title: (mpris.playbackStatus != Mpris.Stopped ? mpris.trackTitle : null) || window.title
 
-    Timer {
-        id: previewTimer
-        interval: 200
-        onTriggered: window.preview(item.screen)
+    ToolTip {
+        id: thumbnailTip
+        anchors.fill: parent
+        content: WindowThumbnail {
+            width: 200
+            height: 150
+            sourceSize: Qt.size(width, height)
+            window: mousearea.containsMouse ? item.window : null
+        }
     }
 
     MouseArea {
@@ -135,14 +140,8 @@ Item {
                 menu.popup();
             }
         }
-        onEntered: previewTimer.start()
-        onExited: {
-            if (previewTimer.running) {
-                previewTimer.stop();
-            } else {
-                window.endPreview(item.screen);
-            }
-        }
+        onEntered: thumbnailTip.show()
+        onExited: thumbnailTip.hide()
 
         StyleItem {
             id: style
@@ -170,10 +169,24 @@ Item {
         }
 
         Rectangle {
-            width: mpris.trackLength ? parent.width * mpris.trackPosition / mpris.trackLength : 0
+            id: progress
+            property real position: mpris.trackPosition
+            width: mpris.trackLength ? parent.width * position / mpris.trackLength : 0
             height: 10
             y: parent.height - 0.5
             color: "#C12E78"
+
+            // the position is not notified while playing, read it again when the bar would grow by a pixel
+            Timer {
+                running: mpris.playbackStatus == Mpris.Playing && item.visible && progress.parent.width > 0
+                interval: Math.max(100, mpris.trackLength / progress.parent.width / Math.max(mpris.rate, 0.01))
+                repeat: true
+                onTriggered: progress.position = mpris.trackPosition
+            }
+            Connections {
+                target: mpris
+                onTrackPositionChanged: progress.position = mpris.trackPosition
+            }
         }
     }
 
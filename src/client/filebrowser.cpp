@@ -17,37 +17,109 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
 #include <QtQml>
+#include <QThread>
 
 #include <filebrowser.h>
 
 static const int a = qmlRegisterType<FileBrowser>("Orbital", 1, 0, "FileBrowser");
-static const int b = qmlRegisterType<FileInfo>();
 
-FileInfo::FileInfo(const QString &path)
-        : m_info(path)
-{
-}
+/*
+ * Lives in the worker thread. The names are all read and sorted first, which
+ * is quick, then the entries are checked and sent in chunks in order.
+ */
+class DirectoryLister : public QObject
+{
+    Q_OBJECT
+public:
+    static const int ChunkSize = 200;
+
+    Q_INVOKABLE void list(quint64 generation, const QString &path, const QStringList &filters)
+    {
+        DIR *dir = opendir(QFile::encodeName(path).constData());
+        if (!dir) {
+            emit done(generation);
+            return;
+        }
+
+        struct Name {
+            QString name;
+            unsigned char type;
+        };
+        QVector<Name> names;
+        while (dirent *entry = readdir(dir)) {
+            // skip . and .. and the hidden files
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            names << Name{ QFile::decodeName(entry->d_name), entry->d_type };
+        }
+
+        std::sort(names.begin(), names.end(), [](const Name &a, const Name &b) {
+            return a.name.compare(b.name, Qt::CaseInsensitive) < 0;
+        });
+
+        int fd = dirfd(dir);
+        QVector<FileBrowser::Entry> chunk;
+        for (const Name &n: names) {
+            bool isDir = n.type == DT_DIR;
+            // the type of symlinks is the type of what they point to
+            if (n.type == DT_UNKNOWN || n.type == DT_LNK) {
+                struct stat st;
+                if (fstatat(fd, QFile::encodeName(n.name).constData(), &st, 0) != 0) {
+                    continue;
+                }
+                isDir = S_ISDIR(st.st_mode);
+            }
+            if (!isDir && !QDir::match(filters, n.name)) {
+                continue;
+            }
+
+            chunk << FileBrowser::Entry{ n.name, isDir };
+            if (chunk.count() == ChunkSize) {
+                emit listed(generation, chunk);
+                chunk.clear();
+            }
+        }
+        closedir(dir);
+
+        if (!chunk.isEmpty()) {
+            emit listed(generation, chunk);
+        }
+        emit done(generation);
+    }
 
-QString FileInfo::name() const
-{
-    return m_info.fileName();
-}
+signals:
+    void listed(quint64 generation, const QVector<FileBrowser::Entry> &entries);
+    void done(quint64 generation);
+};
 
-bool FileInfo::isDir() const
+FileBrowser::FileBrowser(QObject *p)
+           : QAbstractListModel(p)
+           , m_generation(0)
+           , m_loading(false)
+           , m_lister(new DirectoryLister)
+           , m_listerThread(new QThread(this))
 {
-    return m_info.isDir();
-}
+    qRegisterMetaType<QVector<FileBrowser::Entry>>();
 
-QString FileInfo::path() const
-{
-    return m_info.filePath();
+    m_lister->moveToThread(m_listerThread);
+    connect(m_listerThread, &QThread::finished, m_lister, &QObject::deleteLater);
+    connect(m_lister, &DirectoryLister::listed, this, &FileBrowser::entriesListed);
+    connect(m_lister, &DirectoryLister::done, this, &FileBrowser::listingDone);
+    m_listerThread->start();
 }
 
-
-FileBrowser::FileBrowser(QObject *p)
-           : QObject(p)
+FileBrowser::~FileBrowser()
 {
+    m_listerThread->quit();
+    m_listerThread->wait();
 }
 
 void FileBrowser::setPath(const QString &path)
@@ -100,31 +172,64 @@ QStringList FileBrowser::nameFilters() const
     return m_dir.nameFilters();
 }
 
-int FileBrowser::filesCount(QQmlListProperty<FileInfo> *prop)
+int FileBrowser::rowCount(const QModelIndex &parent) const
 {
-    FileBrowser *c = static_cast<FileBrowser *>(prop->object);
-    return c->m_files.count();
+    return parent.isValid() ? 0 : m_files.count();
 }
 
-FileInfo *FileBrowser::fileAt(QQmlListProperty<FileInfo> *prop, int index)
+QVariant FileBrowser::data(const QModelIndex &index, int role) const
 {
-    FileBrowser *c = static_cast<FileBrowser *>(prop->object);
-    return c->m_files.at(index);
+    const Entry &entry = m_files.at(index.row());
+    switch (role) {
+        case Qt::DisplayRole:
+        case NameRole: return entry.name;
+        case PathRole: return m_dir.filePath(entry.name);
+        case IsDirRole: return entry.isDir;
+    }
+    return QVariant();
 }
 
-QQmlListProperty<FileInfo> FileBrowser::dirContent()
+QHash<int, QByteArray> FileBrowser::roleNames() const
 {
-    return QQmlListProperty<FileInfo>(this, 0, filesCount, fileAt);
+    QHash<int, QByteArray> roles;
+    roles.insert(NameRole, "name");
+    roles.insert(PathRole, "path");
+    roles.insert(IsDirRole, "isDir");
+    return roles;
 }
 
 void FileBrowser::rebuildFilesList()
 {
-    foreach (FileInfo *f, m_files) {
-        f->deleteLater();
-    }
+    beginResetModel();
     m_files.clear();
-    QStringList files = m_dir.entryList(QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
-    foreach (const QString &s, files) {
-        m_files << new FileInfo(m_dir.filePath(s));
+    endResetModel();
+
+    // the chunks of the previous listing still in the queue are thrown away
+    QMetaObject::invokeMethod(m_lister, "list", Q_ARG(quint64, ++m_generation),
+                              Q_ARG(QString, m_dir.absolutePath()), Q_ARG(QStringList, m_dir.nameFilters()));
+    if (!m_loading) {
+        m_loading = true;
+        emit loadingChanged();
     }
 }
+
+void FileBrowser::entriesListed(quint64 generation, const QVector<Entry> &entries)
+{
+    if (generation != m_generation) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_files.count(), m_files.count() + entries.count() - 1);
+    m_files << entries;
+    endInsertRows();
+}
+
+void FileBrowser::listingDone(quint64 generation)
+{
+    if (generation == m_generation && m_loading) {
+        m_loading = false;
+        emit loadingChanged();
+    }
+}
+
+#include "filebrowser.moc"
@@ -20,43 +20,49 @@
 #ifndef FILEBROWSER_H
 #define FILEBROWSER_H
 
-#include <QObject>
+#include <QAbstractListModel>
 #include <QDir>
+#include <QVector>
 
-class FileInfo : public QObject
-{
-    Q_OBJECT
-    Q_PROPERTY(QString name READ name NOTIFY nameChanged)
-public:
-    FileInfo(const QString &file);
-
-    QString name() const;
-
-    Q_INVOKABLE bool isDir() const;
-    Q_INVOKABLE QString path() const;
-
-signals:
-    void nameChanged();
-
-private:
-    QFileInfo m_info;
-};
+class QThread;
+class DirectoryLister;
 
-class FileBrowser : public QObject
+/*
+ * The content of a directory, as a model with the name, path and isDir roles.
+ * The directory is read in a worker thread and the entries are added in chunks
+ * as they come, so that big directories don't block the ui.
+ */
+class FileBrowser : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(QString path READ path WRITE setPath NOTIFY pathChanged)
     Q_PROPERTY(QStringList nameFilters READ nameFilters WRITE setNameFilters)
-    Q_PROPERTY(QQmlListProperty<FileInfo> dirContent READ dirContent NOTIFY pathChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
 public:
+    struct Entry {
+        QString name;
+        bool isDir;
+    };
+
+    enum Roles {
+        NameRole = Qt::UserRole + 1,
+        PathRole,
+        IsDirRole
+    };
+
     FileBrowser(QObject *p = nullptr);
+    ~FileBrowser();
 
     void setPath(const QString &path);
     void setNameFilters(const QStringList &filters);
 
     QString path() const;
     QStringList nameFilters() const;
-    QQmlListProperty<FileInfo> dirContent();
+    bool loading() const { return m_loading; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
 
 public slots:
     void cdUp();
@@ -65,14 +71,21 @@ public slots:
 
 signals:
     void pathChanged();
+    void loadingChanged();
 
 private:
     void rebuildFilesList();
-    static int filesCount(QQmlListProperty<FileInfo> *prop);
-    static FileInfo *fileAt(QQmlListProperty<FileInfo> *prop, int index);
+    void entriesListed(quint64 generation, const QVector<FileBrowser::Entry> &entries);
+    void listingDone(quint64 generation);
 
     QDir m_dir;
-    QList<FileInfo *> m_files;
+    QVector<Entry> m_files;
+    quint64 m_generation;
+    bool m_loading;
+    DirectoryLister *m_lister;
+    QThread *m_listerThread;
 };
 
+Q_DECLARE_METATYPE(FileBrowser::Entry)
+
 #endif
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QIcon>
+#include <QGuiApplication>
+#include <QStandardPaths>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+#include "iconcache.h"
+
+// rendering an icon faster than this is cheaper than loading it from disk
+static const int DiskCacheThreshold = 2;
+
+static int sizeBucket(const QSize &size)
+{
+    static const int buckets[] = { 16, 22, 24, 32, 48, 64, 96, 128, 256 };
+
+    int s = qMax(size.width(), size.height());
+    for (int b: buckets) {
+        if (s <= b) {
+            return b;
+        }
+    }
+    return (s + 63) & ~63;
+}
+
+IconCache::IconCache()
+         : m_cache(MaxCost)
+         , m_diskCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/icons"))
+{
+}
+
+IconCache *IconCache::instance()
+{
+    static IconCache cache;
+    return &cache;
+}
+
+QImage IconCache::icon(const QString &name, const QSize &size)
+{
+    IconCache *cache = instance();
+    qreal scale = qGuiApp->devicePixelRatio();
+
+    QString key = QStringLiteral("%1@%2x%3@%4").arg(name).arg(size.width()).arg(size.height()).arg(scale);
+    QImage image = cache->lookup(key);
+    if (!image.isNull()) {
+        return image;
+    }
+
+    int bucket = sizeBucket(size);
+    QString bucketKey = QStringLiteral("%1@%2@%3").arg(name).arg(bucket).arg(scale);
+    image = cache->lookup(bucketKey);
+    if (image.isNull()) {
+        image = cache->render(name, bucket, scale);
+        if (image.isNull()) {
+            return image;
+        }
+        cache->insert(bucketKey, image);
+    }
+
+    QSize scaledSize = size * scale;
+    if (image.width() > scaledSize.width() || image.height() > scaledSize.height()) {
+        image = image.scaled(scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        image.setDevicePixelRatio(scale);
+        cache->insert(key, image);
+    }
+    return image;
+}
+
+QImage IconCache::lookup(const QString &key)
+{
+    QMutexLocker lock(&m_cacheMutex);
+    QImage *image = m_cache.object(key);
+    return image ? *image : QImage();
+}
+
+void IconCache::insert(const QString &key, const QImage &image)
+{
+    QMutexLocker lock(&m_cacheMutex);
+    m_cache.insert(key, new QImage(image), image.byteCount());
+}
+
+QImage IconCache::render(const QString &name, int bucket, qreal scale)
+{
+    QString file = diskFile(name, bucket, scale);
+    if (!file.isEmpty()) {
+        QImage image(file);
+        if (!image.isNull()) {
+            image.setDevicePixelRatio(scale);
+            return image;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QImage image;
+    {
+        QMutexLocker lock(&m_renderMutex);
+        QIcon icon = QIcon::fromTheme(name);
+        if (icon.isNull()) {
+            return QImage();
+        }
+        image = icon.pixmap(QSize(bucket, bucket)).toImage();
+    }
+
+    if (!file.isEmpty() && timer.elapsed() >= DiskCacheThreshold) {
+        class SaveTask : public QRunnable
+        {
+        public:
+            SaveTask(const QString &f, const QImage &i) : file(f), image(i) {}
+            void run() override
+            {
+                QDir().mkpath(QFileInfo(file).path());
+                if (!image.save(file, "PNG")) {
+                    qWarning("IconCache: failed to write '%s'.", qPrintable(file));
+                }
+            }
+
+            QString file;
+            QImage image;
+        };
+        QThreadPool::globalInstance()->start(new SaveTask(file, image));
+    }
+
+    return image;
+}
+
+// returns the path of the cached icon, if it can be used. If the file doesn't exist
+// yet it returns the path anyway, so that the icon can be saved there.
+QString IconCache::diskFile(const QString &name, int bucket, qreal scale)
+{
+    if (name.contains(QLatin1Char('/'))) {
+        return QString();
+    }
+
+    QString theme;
+    QDateTime modified;
+    {
+        QMutexLocker lock(&m_renderMutex);
+        theme = QIcon::themeName();
+        modified = themeModified(theme);
+    }
+
+    QString file = QStringLiteral("%1/%2/%3@%4/%5.png").arg(m_diskCache, theme).arg(bucket).arg(scale).arg(name);
+    QFileInfo info(file);
+    if (info.exists() && info.lastModified() < modified) {
+        QFile::remove(file);
+    }
+    return file;
+}
+
+// an icon theme being updated changes the mtime of its index.theme, use that to
+// know when the icons on disk are stale
+QDateTime IconCache::themeModified(const QString &theme)
+{
+    auto it = m_themes.constFind(theme);
+    if (it != m_themes.constEnd()) {
+        return *it;
+    }
+
+    QDateTime modified;
+    foreach (const QString &path, QIcon::themeSearchPaths()) {
+        QFileInfo info(path + QLatin1Char('/') + theme + QStringLiteral("/index.theme"));
+        if (info.exists() && (!modified.isValid() || info.lastModified() > modified)) {
+            modified = info.lastModified();
+        }
+    }
+    m_themes.insert(theme, modified);
+    return modified;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QDateTime>
+
+/*
+ * A process wide cache of the rasterized theme icons, shared by all the image providers.
+ * Icons are rendered at a few fixed sizes and scaled down from there, so that items
+ * being resized don't make us render the same icon over and over. The memory used is
+ * bounded, evicting the least recently used icons first.
+ * Icons that are slow to render, usually the scalable ones, are also written to disk
+ * so that they are cheap to load at the next startup.
+ * All the functions are thread safe, so the cache can be used by asynchronous image
+ * providers too.
+ */
+class IconCache
+{
+public:
+    static const int MaxCost = 16 << 20;
+
+    /**
+     * Returns the theme icon with the given name, at most as big as the size.
+     * Returns a null image if the icon cannot be found.
+     */
+    static QImage icon(const QString &name, const QSize &size);
+
+private:
+    IconCache();
+    static IconCache *instance();
+
+    QImage lookup(const QString &key);
+    void insert(const QString &key, const QImage &image);
+    QImage render(const QString &name, int bucket, qreal scale);
+    QString diskFile(const QString &name, int bucket, qreal scale);
+    QDateTime themeModified(const QString &theme);
+
+    QMutex m_cacheMutex;
+    QCache<QString, QImage> m_cache;
+    // QIcon and the icon loader are not thread safe
+    QMutex m_renderMutex;
+    QString m_diskCache;
+    QHash<QString, QDateTime> m_themes;
+};
+
+#endif
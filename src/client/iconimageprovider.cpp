@@ -17,26 +17,26 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QIcon>
 #include <QDebug>
 
 #include "iconimageprovider.h"
+#include "iconcache.h"
 
 IconImageProvider::IconImageProvider()
-                 : QQuickImageProvider(QQuickImageProvider::Pixmap)
+                 : QQuickImageProvider(QQuickImageProvider::Image)
 {
 }
 
-QPixmap IconImageProvider::requestPixmap(const QString &id, QSize *realSize, const QSize &requestedSize)
+QImage IconImageProvider::requestImage(const QString &id, QSize *realSize, const QSize &requestedSize)
 {
     QSize size(requestedSize);
     if (size.width() < 1) size.setWidth(1);
     if (size.height() < 1) size.setHeight(1);
-    QIcon icon = QIcon::fromTheme(id);
-    if (icon.isNull()) {
-        icon = QIcon::fromTheme(QStringLiteral("image-missing"));
+    QImage image = IconCache::icon(id, size);
+    if (image.isNull()) {
+        image = IconCache::icon(QStringLiteral("image-missing"), size);
     }
     *realSize = size;
 
-    return icon.pixmap(size);
+    return image;
 }
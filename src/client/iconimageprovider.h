@@ -27,7 +27,7 @@ class IconImageProvider : public QQuickImageProvider
 public:
     IconImageProvider();
 
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize);
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
 };
 
 #endif
@@ -21,6 +21,7 @@
 #include <QDebug>
 
 #include "layout.h"
+#include "layoutsolver.h"
 
 static const int a = qmlRegisterType<Layout>("Orbital", 1, 0, "Layout");
 static const int b = qmlRegisterType<LayoutAttached>();
@@ -135,7 +136,6 @@ void LayoutAttached::setOrientation(Qt::Orientation o)
 
 Layout::Layout(QQuickItem *p)
       : QQuickItem(p)
-      , m_dirty(false)
       , m_spacing(0)
       , m_orientation(Qt::Horizontal)
 {
@@ -146,13 +146,9 @@ LayoutAttached *Layout::qmlAttachedProperties(QObject *object)
     return new LayoutAttached(object);
 }
 
-bool Layout::event(QEvent *e)
+void Layout::updatePolish()
 {
-    if (e->type() == QEvent::LayoutRequest) {
-        relayout();
-    }
-
-    return QQuickItem::event(e);
+    relayout();
 }
 
 void Layout::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
@@ -166,11 +162,13 @@ void Layout::itemChange(ItemChange change, const ItemChangeData &value)
         case QQuickItem::ItemChildAddedChange:
             m_items << value.item;
             connect(value.item, &QQuickItem::visibleChanged, this, &Layout::invalidate);
+            updateIndexes();
             invalidate();
             break;
         case QQuickItem::ItemChildRemovedChange:
             m_items.removeOne(value.item);
             disconnect(value.item);
+            updateIndexes();
             invalidate();
             break;
         default:
@@ -191,6 +189,7 @@ void Layout::insertAt(QQuickItem *item, int col)
     }
     m_items.insert(col, item);
 
+    updateIndexes();
     invalidate();
 }
 
@@ -210,6 +209,7 @@ void Layout::insertBefore(QQuickItem *item, QQuickItem *before)
         }
     }
 
+    updateIndexes();
     invalidate();
 }
 
@@ -229,10 +229,11 @@ void Layout::insertAfter(QQuickItem *item, QQuickItem *after)
         }
     }
 
+    updateIndexes();
     invalidate();
 }
 
-void Layout::invalidate()
+void Layout::updateIndexes()
 {
     for (int i = 0; i < m_items.size(); ++i) {
         QQuickItem *item = m_items.at(i);
@@ -240,12 +241,13 @@ void Layout::invalidate()
         la->m_index = i;
         la->setOrientation(m_orientation);
     }
+}
 
-    if (m_dirty)
-        return;
-
-    m_dirty = true;
-    QCoreApplication::postEvent(this, new QEvent(QEvent::LayoutRequest));
+void Layout::invalidate()
+{
+    // many invalidations can happen in a frame, e.g. when a lot of windows are added
+    // at once to the taskbar, lay out only once before the next frame is rendered
+    polish();
 }
 
 void Layout::setSpacing(qreal spacing)
@@ -258,91 +260,50 @@ void Layout::setOrientation(Qt::Orientation orientation)
 {
     if (orientation != m_orientation) {
         m_orientation = orientation;
+        updateIndexes();
         invalidate();
     }
 }
 
 void Layout::relayout()
 {
-    m_dirty = false;
-
-    struct It {
-        QQuickItem *item;
-        LayoutAttached *la;
-        bool resize;
-        qreal x;
-        qreal w;
-    };
-    QList<It> _items;
+    const bool horizontal = m_orientation == Qt::Horizontal;
+
+    m_layoutItems.clear();
+    m_headrooms.clear();
+    qreal used = 0;
     foreach (QQuickItem *i, m_items) {
-        if (i->isVisible()) {
-            _items.append({ i, attachedLayoutObject(i), true, 0, 0 });
+        if (!i->isVisible()) {
+            continue;
         }
-    }
 
-    const bool horizontal = m_orientation == Qt::Horizontal;
-    qreal x = 0;
-    for (int j = 0; j < _items.count(); ++j) {
-        It &i = _items[j];
-        i.x = x;
-        i.w = horizontal ? i.la->minimumWidth() : i.la->minimumHeight();
-
-        x += i.w + m_spacing;
+        LayoutAttached *la = attachedLayoutObject(i);
+        qreal min = horizontal ? la->minimumWidth() : la->minimumHeight();
+        // items grow up to their preferred size, or up to their maximum size if they fill.
+        // The minimum size wins over those if they are smaller than it.
+        bool fill = horizontal ? la->fillWidth() : la->fillHeight();
+        qreal max = fill ? (horizontal ? la->maximumWidth() : la->maximumHeight())
+                         : (horizontal ? la->preferredWidth() : la->preferredHeight());
+        qreal headroom = qMax(max - min, qreal(0));
+
+        m_layoutItems.push_back({ i, la, min, headroom });
+        m_headrooms.push_back(headroom);
+        used += min + m_spacing;
     }
 
-    bool again;
-    int num = _items.count();
-    do {
-        again = false;
-        qreal spaceLeft = (horizontal ? width() : height()) - x;
-        if (spaceLeft <= 0) {
-            break;
-        }
+    qreal increment = layoutIncrement(m_headrooms, (horizontal ? width() : height()) - used);
 
-        spaceLeft /= num;
-        x = 0;
-        for (int j = 0; j < _items.count(); ++j) {
-            It &i = _items[j];
-            i.x = x;
-            if (i.resize) {
-                i.w += spaceLeft;
-                qreal max = horizontal ? i.la->maximumWidth() : i.la->maximumHeight();
-                qreal pref = horizontal ? i.la->preferredWidth() : i.la->preferredHeight();
-                if ((horizontal ? i.la->fillWidth() : i.la->fillHeight())) {
-                    if (max < i.w) {
-                        i.w = max;
-                        i.resize = false;
-                        --num;
-                        again = true;
-                    } else if (spaceLeft > 1) {
-                        again = true;
-                    }
-                } else if (pref < i.w) {
-                    i.w = pref;
-                    i.resize = false;
-                    --num;
-                    again = true;
-                }
-            }
-            x += i.w + m_spacing;
-        }
-    } while (again);
-
-    if (horizontal) {
-        for (int j = 0; j < _items.count(); ++j) {
-            It &i = _items[j];
-            i.item->setProperty("x", i.x);
-            i.item->setProperty("y", 0);
-            i.item->setProperty("width", i.w);
-            i.item->setProperty("height", height());
+    qreal x = 0;
+    for (LayoutItem &i: m_layoutItems) {
+        i.size += qMin(i.headroom, increment);
+        QRectF geometry = horizontal ? QRectF(x, 0, i.size, height()) : QRectF(0, x, width(), i.size);
+        x += i.size + m_spacing;
+
+        if (geometry.topLeft() != i.item->position()) {
+            i.item->setPosition(geometry.topLeft());
         }
-    } else {
-        for (int j = 0; j < _items.count(); ++j) {
-            It &i = _items[j];
-            i.item->setProperty("y", i.x);
-            i.item->setProperty("x", 0);
-            i.item->setProperty("height", i.w);
-            i.item->setProperty("width", width());
+        if (geometry.size() != QSizeF(i.item->width(), i.item->height())) {
+            i.item->setSize(geometry.size());
         }
     }
 }
@@ -20,6 +20,8 @@
 #ifndef LAYOUT_H
 #define LAYOUT_H
 
+#include <vector>
+
 #include <QQuickItem>
 
 class LayoutAttached;
@@ -47,13 +49,23 @@ public:
     static LayoutAttached *qmlAttachedProperties(QObject *object);
 
 protected:
-    bool event(QEvent *e) override;
+    void updatePolish() override;
     void itemChange(ItemChange change, const ItemChangeData &value) override;
     void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
 
 private:
+    void updateIndexes();
+
+    struct LayoutItem {
+        QQuickItem *item;
+        LayoutAttached *la;
+        qreal size;
+        qreal headroom;
+    };
+
     QList<QQuickItem *> m_items;
-    bool m_dirty;
+    std::vector<LayoutItem> m_layoutItems;
+    std::vector<qreal> m_headrooms;
     qreal m_spacing;
     Qt::Orientation m_orientation;
 };
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAYOUTSOLVER_H
+#define LAYOUTSOLVER_H
+
+#include <algorithm>
+#include <vector>
+
+#include <QtGlobal>
+
+/*
+ * Every item of a layout gets its minimum size, then the space left is shared equally
+ * between them, with the items that don't need their whole share giving what remains to
+ * the others. Going through the items sorted by how much they can grow this finds in one
+ * pass the size increment every item gets, capped by its headroom.
+ * The headrooms are sorted in place.
+ */
+inline qreal layoutIncrement(std::vector<qreal> &headrooms, qreal spaceLeft)
+{
+    if (spaceLeft <= 0 || headrooms.empty()) {
+        return 0;
+    }
+
+    std::sort(headrooms.begin(), headrooms.end());
+    size_t count = headrooms.size();
+    for (size_t j = 0; j < count; ++j) {
+        qreal share = spaceLeft / (count - j);
+        if (headrooms[j] > share) {
+            return share;
+        }
+        spaceLeft -= headrooms[j];
+    }
+    return headrooms.back();
+}
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QUrl>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+#include "manifestindex.h"
+
+// bump this when changing the format of the index
+static const quint32 IndexVersion = 2;
+
+static qint64 modificationTime(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+ManifestIndex::ManifestIndex(const QString &name, const QString &manifestName)
+             : m_file(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1Char('/') + name + QStringLiteral(".index"))
+             , m_manifestName(manifestName)
+             , m_dirty(false)
+{
+    load();
+}
+
+ManifestIndex::~ManifestIndex()
+{
+    if (m_dirty) {
+        save();
+    }
+}
+
+void ManifestIndex::scan(const QString &rootPath, const Callback &callback)
+{
+    QDir dir(QUrl(rootPath).toString(QUrl::NormalizePathSegments));
+    QString path = dir.absolutePath();
+    QFileInfo info(path);
+    if (!info.isDir()) {
+        if (m_roots.remove(path) > 0) {
+            m_dirty = true;
+        }
+        return;
+    }
+
+    qint64 mtime = modificationTime(info);
+    auto it = m_roots.find(path);
+    bool cached = it != m_roots.end();
+    const Root old = cached ? *it : Root{ 0, QVector<Entry>() };
+
+    // adding or removing an element changes the mtime of the directory, only list it in that case
+    QStringList subdirs;
+    if (cached && old.mtime == mtime) {
+        for (const Entry &e: old.entries) {
+            subdirs << e.name;
+        }
+    } else {
+        subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        m_dirty = true;
+    }
+
+    QHash<QString, const Entry *> oldEntries;
+    for (const Entry &e: old.entries) {
+        oldEntries.insert(e.name, &e);
+    }
+
+    Root root = { mtime, QVector<Entry>() };
+    for (const QString &subdir: subdirs) {
+        QString subdirPath = dir.absoluteFilePath(subdir);
+        QFileInfo subdirInfo(subdirPath);
+        if (!subdirInfo.isDir()) {
+            m_dirty = true;
+            continue;
+        }
+
+        // the directories without a valid manifest are remembered too, adding
+        // the manifest later changes the mtime of their directory but not the root's
+        QFileInfo manifest(subdirPath + QLatin1Char('/') + m_manifestName);
+        Entry entry = { subdir, modificationTime(subdirInfo), manifest.exists() ? modificationTime(manifest) : 0, QByteArray() };
+        const Entry *oldEntry = oldEntries.value(subdir);
+        if (oldEntry && oldEntry->dirMtime == entry.dirMtime && oldEntry->mtime == entry.mtime) {
+            entry.manifest = oldEntry->manifest;
+        } else {
+            m_dirty = true;
+            if (manifest.exists()) {
+                readManifest(manifest.filePath(), entry);
+            }
+        }
+
+        root.entries << entry;
+        if (!entry.manifest.isEmpty()) {
+            callback(subdir, subdirPath, QJsonDocument::fromBinaryData(entry.manifest).object());
+        }
+    }
+
+    m_roots.insert(path, root);
+}
+
+bool ManifestIndex::readManifest(const QString &path, Entry &entry)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << QStringLiteral("Could not open %1 for reading.").arg(path);
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning("Error parsing %s at offset %d: %s", qPrintable(path), error.offset, qPrintable(error.errorString()));
+        return false;
+    }
+
+    // the binary representation can be used directly when loading it back
+    entry.manifest = doc.toBinaryData();
+    return true;
+}
+
+void ManifestIndex::load()
+{
+    QFile file(m_file);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    quint32 version;
+    stream >> version;
+    if (version != IndexVersion) {
+        return;
+    }
+
+    quint32 numRoots;
+    stream >> numRoots;
+    for (quint32 i = 0; i < numRoots && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Root root;
+        quint32 numEntries;
+        stream >> path >> root.mtime >> numEntries;
+        for (quint32 j = 0; j < numEntries && stream.status() == QDataStream::Ok; ++j) {
+            Entry entry;
+            stream >> entry.name >> entry.dirMtime >> entry.mtime >> entry.manifest;
+            root.entries << entry;
+        }
+        m_roots.insert(path, root);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Corrupted index" << m_file << ", ignoring it.";
+        m_roots.clear();
+    }
+}
+
+void ManifestIndex::save()
+{
+    QDir().mkpath(QFileInfo(m_file).absolutePath());
+    QSaveFile file(m_file);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write the index" << m_file << ":" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << IndexVersion << (quint32)m_roots.count();
+    for (auto it = m_roots.constBegin(); it != m_roots.constEnd(); ++it) {
+        stream << it.key() << it->mtime << (quint32)it->entries.count();
+        for (const Entry &entry: it->entries) {
+            stream << entry.name << entry.dirMtime << entry.mtime << entry.manifest;
+        }
+    }
+    file.commit();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MANIFESTINDEX_H
+#define MANIFESTINDEX_H
+
+#include <functional>
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+
+class QJsonObject;
+
+/*
+ * An on-disk index of the manifests of the elements or of the styles, so that at startup
+ * we don't need to read and parse all of them. A cached manifest is used as long as its
+ * modification time and the one of its directory don't change, and the root directories
+ * are only listed again when their modification time changes.
+ */
+class ManifestIndex
+{
+public:
+    typedef std::function<void (const QString &name, const QString &path, const QJsonObject &manifest)> Callback;
+
+    ManifestIndex(const QString &name, const QString &manifestName);
+    ~ManifestIndex();
+
+    /**
+     * Call the callback for every subdirectory of the root containing a valid manifest.
+     */
+    void scan(const QString &root, const Callback &callback);
+
+private:
+    struct Entry {
+        QString name;
+        qint64 dirMtime;
+        // the mtime of the manifest, the manifest is empty if missing or invalid
+        qint64 mtime;
+        QByteArray manifest;
+    };
+    struct Root {
+        qint64 mtime;
+        QVector<Entry> entries;
+    };
+
+    bool readManifest(const QString &path, Entry &entry);
+    void load();
+    void save();
+
+    QString m_file;
+    QString m_manifestName;
+    QHash<QString, Root> m_roots;
+    bool m_dirty;
+};
+
+#endif
@@ -80,6 +80,11 @@ Item {
                     }
                 }
 
+                MouseArea {
+                    anchors.fill: parent
+                    onClicked: NotificationsManager.dismiss(notification.id)
+                }
+
                 NumberAnimation { target: content; property: "opacity"; to: 1; duration: 300; running: true }
                 SequentialAnimation {
                     id: fadeOutAnim
@@ -90,6 +95,11 @@ Item {
                 Connections {
                     target: notification
                     onExpired: fadeOutAnim.start()
+                    onChanged: {
+                        notif.summary = notification.summary;
+                        notif.body = notification.body;
+                        notif.icon = notification.iconSource;
+                    }
                 }
             }
         }
@@ -100,7 +110,7 @@ Item {
         onNotify: {
             component.createObject(root, { notification: notification, body: notification.body,
                                            summary: notification.summary,
-                                           icon: "image://notifications/" + notification.id });
+                                           icon: notification.iconSource });
         }
     }
 }
\ No newline at end of file
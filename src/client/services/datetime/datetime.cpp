@@ -18,6 +18,7 @@
  */
 
 #include "datetime.h"
+#include "ticker.h"
 
 #include <QDebug>
 #include <QtQml>
@@ -33,7 +34,7 @@ void DateTimePlugin::registerTypes(const char *uri)
 DateTime::DateTime(QObject *p)
         : QObject(p)
 {
-    startTimer(250);
+    connect(Ticker::instance(), &Ticker::second, this, [this]() { setDT(QDateTime::currentDateTime()); });
 
     setDT(QDateTime::currentDateTime());
 }
@@ -53,19 +54,10 @@ QString DateTime::date() const
     return m_dateTime.date().toString(Qt::DefaultLocaleShortDate);
 }
 
-void DateTime::timerEvent(QTimerEvent *event)
-{
-    QDateTime dt = QDateTime::currentDateTime();
-    if (dt.toTime_t() != m_nsecs) {
-        setDT(dt);
-    }
-}
-
 void DateTime::setDT(const QDateTime &dt)
 {
     QString d = date();
     m_dateTime = dt;
-    m_nsecs = dt.toTime_t();
 
     emit timeChanged();
     if (d != date()) {
@@ -47,14 +47,10 @@ signals:
     void timeChanged();
     void dateChanged();
 
-protected:
-    virtual void timerEvent(QTimerEvent *event) override;
-
 private:
     void setDT(const QDateTime &dt);
 
     QDateTime m_dateTime;
-    uint m_nsecs;
 };
 
 #endif
@@ -21,7 +21,7 @@
 #include <QtQml>
 
 #include "hardwareservice.h"
-#include "clibackend.h"
+#include "sysfsbackend.h"
 #ifdef USE_SOLID
 #include "solidbackend.h"
 #endif
@@ -46,17 +46,26 @@ Device::Device(const QString &udi)
 
 void Device::setType(Type t)
 {
-    m_type = t;
+    if (m_type != t) {
+        m_type = t;
+        emit changed();
+    }
 }
 
 void Device::setName(const QString &name)
 {
-    m_name = name;
+    if (m_name != name) {
+        m_name = name;
+        emit changed();
+    }
 }
 
 void Device::setIconName(const QString &name)
 {
-    m_icon = name;
+    if (m_icon != name) {
+        m_icon = name;
+        emit changed();
+    }
 }
 
 
@@ -76,25 +85,26 @@ void Battery::setName(const QString &name)
 
 void Battery::setChargePercent(int charge)
 {
-    if (m_chargePercent != charge) {
-        m_chargePercent = charge;
-        emit chargePercentChanged();
-    }
+    setState(charge, m_chargeState, m_remainingTime);
 }
 
 void Battery::setChargeState(ChargeState cs)
 {
-    if (m_chargeState != cs) {
-        m_chargeState = cs;
-        emit chargeStateChanged();
-    }
+    setState(m_chargePercent, cs, m_remainingTime);
 }
 
 void Battery::setRemainingTime(qint64 time)
 {
-    if (m_remainingTime != time) {
+    setState(m_chargePercent, m_chargeState, time);
+}
+
+void Battery::setState(int charge, ChargeState cs, qint64 time)
+{
+    if (m_chargePercent != charge || m_chargeState != cs || m_remainingTime != time) {
+        m_chargePercent = charge;
+        m_chargeState = cs;
         m_remainingTime = time;
-        emit remainingTimeChanged();
+        emit changed();
     }
 }
 
@@ -108,7 +118,7 @@ HardwareManager::HardwareManager(QObject *p)
     m_backend = SolidBackend::create(this);
 #endif
     if (!m_backend) {
-        m_backend = CliBackend::create(this);
+        m_backend = SysfsBackend::create(this);
     }
 }
 
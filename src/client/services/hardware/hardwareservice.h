@@ -36,9 +36,9 @@ class Device : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QString udi READ udi CONSTANT)
-    Q_PROPERTY(QString name READ name CONSTANT)
-    Q_PROPERTY(QString iconName READ iconName CONSTANT)
-    Q_PROPERTY(Type type READ type CONSTANT)
+    Q_PROPERTY(QString name READ name NOTIFY changed)
+    Q_PROPERTY(QString iconName READ iconName NOTIFY changed)
+    Q_PROPERTY(Type type READ type NOTIFY changed)
     Q_PROPERTY(bool mounted READ isMounted NOTIFY mountedChanged)
 public:
     enum class Type {
@@ -65,6 +65,7 @@ public:
 
 signals:
     void mountedChanged();
+    void changed();
 
 private:
     Type m_type;
@@ -78,9 +79,9 @@ class Battery : public QObject
     Q_OBJECT
     Q_PROPERTY(QString udi READ udi CONSTANT)
     Q_PROPERTY(QString name READ name CONSTANT)
-    Q_PROPERTY(int chargePercent READ chargePercent NOTIFY chargePercentChanged)
-    Q_PROPERTY(ChargeState chargeState READ chargeState NOTIFY chargeStateChanged)
-    Q_PROPERTY(qint64 remainingTime READ remainingTime NOTIFY remainingTimeChanged)
+    Q_PROPERTY(int chargePercent READ chargePercent NOTIFY changed)
+    Q_PROPERTY(ChargeState chargeState READ chargeState NOTIFY changed)
+    Q_PROPERTY(qint64 remainingTime READ remainingTime NOTIFY changed)
 public:
     enum class ChargeState {
         Stable,
@@ -101,11 +102,13 @@ protected:
     void setChargePercent(int charge);
     void setChargeState(ChargeState c);
     void setRemainingTime(qint64 time);
+    /**
+     * Sets all the state at once, notifying the changes with a single signal.
+     */
+    void setState(int charge, ChargeState c, qint64 time);
 
 signals:
-    void chargePercentChanged();
-    void chargeStateChanged();
-    void remainingTimeChanged();
+    void changed();
 
 private:
     QString m_udi;
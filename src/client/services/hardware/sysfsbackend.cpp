@@ -0,0 +1,395 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QProcess>
+#include <QSocketNotifier>
+#include <QDebug>
+
+#include "sysfsbackend.h"
+
+static QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll().trimmed();
+}
+
+// udev escapes the unsafe characters in the labels as \xNN
+static QString decodeUdevString(const QByteArray &str)
+{
+    QByteArray out;
+    out.reserve(str.size());
+    for (int i = 0; i < str.size(); ++i) {
+        if (str.at(i) == '\\' && i + 3 < str.size() && str.at(i + 1) == 'x') {
+            bool ok;
+            char c = str.mid(i + 2, 2).toInt(&ok, 16);
+            if (ok) {
+                out.append(c);
+                i += 3;
+                continue;
+            }
+        }
+        out.append(str.at(i));
+    }
+    return QString::fromUtf8(out);
+}
+
+static QHash<QByteArray, QByteArray> udevProperties(const QByteArray &devNum)
+{
+    QHash<QByteArray, QByteArray> properties;
+    QFile file(QStringLiteral("/run/udev/data/b") + QString::fromLatin1(devNum));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return properties;
+    }
+    foreach (const QByteArray &line, file.readAll().split('\n')) {
+        if (!line.startsWith("E:")) {
+            continue;
+        }
+        int eq = line.indexOf('=');
+        if (eq > 2) {
+            properties.insert(line.mid(2, eq - 2), line.mid(eq + 1));
+        }
+    }
+    return properties;
+}
+
+static void udisksctl(const QString &command, const QString &device)
+{
+    QProcess *proc = new QProcess;
+    QObject::connect(proc, (void (QProcess::*)(int))&QProcess::finished, proc, &QObject::deleteLater);
+    QObject::connect(proc, &QProcess::errorOccurred, proc, &QObject::deleteLater);
+    proc->start(QStringLiteral("udisksctl"), QStringList() << command << QStringLiteral("-b") << device);
+}
+
+SysfsDevice::SysfsDevice(const QString &udi, const QByteArray &devNum)
+           : Device(udi)
+           , m_devNum(devNum)
+           , m_mounted(false)
+{
+}
+
+bool SysfsDevice::umount()
+{
+    if (type() != Type::Storage) {
+        return false;
+    }
+
+    // the new state will come from the mounts watcher
+    udisksctl(QStringLiteral("unmount"), udi());
+    return true;
+}
+
+bool SysfsDevice::mount()
+{
+    if (type() != Type::Storage) {
+        return false;
+    }
+
+    udisksctl(QStringLiteral("mount"), udi());
+    return true;
+}
+
+void SysfsDevice::setMounted(bool mounted)
+{
+    if (m_mounted != mounted) {
+        m_mounted = mounted;
+        emit mountedChanged();
+    }
+}
+
+
+
+// the uevent file of a power supply has all its properties as POWER_SUPPLY_NAME=value
+static QHash<QByteArray, QByteArray> powerSupplyProperties(const QString &path)
+{
+    QHash<QByteArray, QByteArray> properties;
+    foreach (const QByteArray &line, readFile(path + QStringLiteral("/uevent")).split('\n')) {
+        int eq = line.indexOf('=');
+        if (line.startsWith("POWER_SUPPLY_") && eq > 13) {
+            properties.insert(line.mid(13, eq - 13), line.mid(eq + 1));
+        }
+    }
+    return properties;
+}
+
+SysfsBattery::SysfsBattery(const QString &name)
+            : Battery(QStringLiteral("/sys/class/power_supply/") + name)
+            , m_path(udi())
+            , m_lastEnergy(-1)
+            , m_rate(0)
+            , m_lastState(ChargeState::Stable)
+{
+    auto properties = powerSupplyProperties(m_path);
+    QByteArray model = properties.value("MODEL_NAME");
+    setName(model.isEmpty() ? name : QString::fromUtf8(model));
+
+    m_timer.setSingleShot(true);
+    QObject::connect(&m_timer, &QTimer::timeout, [this]() { refresh(); });
+    refresh();
+}
+
+void SysfsBattery::refresh()
+{
+    auto properties = powerSupplyProperties(m_path);
+
+    QByteArray status = properties.value("STATUS");
+    ChargeState state = status == "Charging" ? ChargeState::Charging :
+                        status == "Discharging" ? ChargeState::Discharging : ChargeState::Stable;
+
+    // some batteries report energy, in µWh, and some report charge, in µAh
+    bool energy = properties.contains("ENERGY_NOW");
+    qint64 now = properties.value(energy ? "ENERGY_NOW" : "CHARGE_NOW").toLongLong();
+    qint64 full = properties.value(energy ? "ENERGY_FULL" : "CHARGE_FULL").toLongLong();
+    qint64 power = properties.value(energy ? "POWER_NOW" : "CURRENT_NOW").toLongLong();
+
+    int charge = properties.contains("CAPACITY") ? properties.value("CAPACITY").toInt()
+                                                 : (full > 0 ? now * 100 / full : 0);
+
+    // the rate is meaningless across a change of state, start over
+    if (state != m_lastState) {
+        m_rate = 0;
+        m_lastEnergy = -1;
+        m_lastState = state;
+    }
+
+    // prefer the instantaneous power the battery reports, if any, else derive it
+    // from the change of energy since the last reading
+    double sample = 0;
+    if (power > 0) {
+        sample = power;
+    } else if (m_lastEnergy >= 0 && m_lastTime.elapsed() > 0) {
+        sample = qAbs(now - m_lastEnergy) * 3600000. / m_lastTime.elapsed();
+    }
+    if (sample > 0) {
+        m_rate = m_rate > 0 ? m_rate * 0.7 + sample * 0.3 : sample;
+    }
+    m_lastEnergy = now;
+    m_lastTime.start();
+
+    qint64 remaining = 0;
+    if (m_rate > 0) {
+        if (state == ChargeState::Discharging) {
+            remaining = now * 3600 / m_rate;
+        } else if (state == ChargeState::Charging) {
+            remaining = qMax<qint64>(0, full - now) * 3600 / m_rate;
+        }
+    }
+
+    setState(qBound(0, charge, 100), state, remaining);
+
+    // read again at about the time the charge changes by 1%
+    int interval = MaxInterval;
+    if (state != ChargeState::Stable && m_rate > 0 && full > 0) {
+        interval = qBound<qint64>(MinInterval, full / 100 * 3600000. / m_rate, MaxInterval);
+    }
+    m_timer.start(interval);
+}
+
+
+
+SysfsBackend::SysfsBackend(HardwareManager *hw)
+            : QObject()
+            , HardwareManager::Backend(hw)
+            , m_monitor(new UeventMonitor(this))
+            , m_mountsFd(open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC))
+            , m_mountsNotifier(nullptr)
+{
+    connect(m_monitor, &UeventMonitor::uevent, this, &SysfsBackend::uevent);
+
+    // mountinfo is flagged as exceptional when the mounts change
+    if (m_mountsFd >= 0) {
+        m_mountsNotifier = new QSocketNotifier(m_mountsFd, QSocketNotifier::Exception, this);
+        connect(m_mountsNotifier, &QSocketNotifier::activated, this, &SysfsBackend::updateMounts);
+    }
+}
+
+SysfsBackend::~SysfsBackend()
+{
+    if (m_mountsFd >= 0) {
+        close(m_mountsFd);
+    }
+}
+
+SysfsBackend *SysfsBackend::create(HardwareManager *hw)
+{
+    SysfsBackend *backend = new SysfsBackend(hw);
+    backend->updateMounts();
+
+    QDir dir(QStringLiteral("/sys/class/block"));
+    foreach (const QString &name, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::System)) {
+        backend->addDevice(name);
+    }
+
+    QDir supplies(QStringLiteral("/sys/class/power_supply"));
+    foreach (const QString &name, supplies.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::System)) {
+        backend->addBattery(name);
+    }
+    return backend;
+}
+
+void SysfsBackend::addDevice(const QString &name)
+{
+    QString path = QStringLiteral("/sys/class/block/") + name;
+    QByteArray devNum = readFile(path + QStringLiteral("/dev"));
+    if (devNum.isEmpty()) {
+        return;
+    }
+
+    SysfsDevice *d = new SysfsDevice(QStringLiteral("/dev/") + name, devNum);
+    if (!updateDevice(name, d)) {
+        delete d;
+        return;
+    }
+
+    m_devices.insert(name, d);
+    deviceAdded(d);
+}
+
+// reads the file system of the device from udev, returning false if it has none
+bool SysfsBackend::updateDevice(const QString &name, SysfsDevice *d)
+{
+    QString path = QStringLiteral("/sys/class/block/") + name;
+    auto properties = udevProperties(d->devNum());
+    QByteArray fsType = properties.value("ID_FS_TYPE");
+    if (fsType.isEmpty()) {
+        return false;
+    }
+
+    if (fsType == "swap") {
+        d->setType(Device::Type::None);
+        d->setMounted(false);
+    } else {
+        d->setType(Device::Type::Storage);
+        // 5 is the SCSI type for cd and dvd drives
+        bool isOptical = readFile(path + QStringLiteral("/device/type")) == "5";
+        if (isOptical) {
+            d->setIconName(QStringLiteral("media-optical"));
+        } else {
+            // partitions don't have the removable flag, their disk has it
+            QString disk = path;
+            if (QFile::exists(path + QStringLiteral("/partition"))) {
+                disk = QFileInfo(QFileInfo(path).canonicalFilePath()).path();
+            }
+            bool isRemovable = readFile(disk + QStringLiteral("/removable")) == "1";
+            d->setIconName(isRemovable ? QStringLiteral("drive-removable-media") : QStringLiteral("drive-harddisk"));
+        }
+
+        QString label = properties.contains("ID_FS_LABEL_ENC") ? decodeUdevString(properties.value("ID_FS_LABEL_ENC"))
+                                                               : QString::fromUtf8(properties.value("ID_FS_LABEL"));
+        d->setName(label.isEmpty() ? d->udi() : label);
+        d->setMounted(m_mounted.contains(d->devNum()) || m_mounted.contains(d->udi().toUtf8()));
+    }
+    return true;
+}
+
+void SysfsBackend::addBattery(const QString &name)
+{
+    QString path = QStringLiteral("/sys/class/power_supply/") + name;
+    // skip the batteries of the mice and such, which have the Device scope
+    if (readFile(path + QStringLiteral("/type")) != "Battery" || readFile(path + QStringLiteral("/scope")) == "Device") {
+        return;
+    }
+
+    SysfsBattery *b = new SysfsBattery(name);
+    m_batteries.insert(name, b);
+    batteryAdded(b);
+}
+
+void SysfsBackend::removeDevice(const QString &name)
+{
+    if (SysfsDevice *d = m_devices.take(name)) {
+        deviceRemoved(d->udi());
+    }
+}
+
+void SysfsBackend::uevent(const UeventMonitor::Properties &properties)
+{
+    QByteArray subsystem = properties.value("SUBSYSTEM");
+    QByteArray devPath = properties.value("DEVPATH");
+    QString name = QString::fromUtf8(devPath.mid(devPath.lastIndexOf('/') + 1));
+    QByteArray action = properties.value("ACTION");
+
+    if (subsystem == "power_supply") {
+        if (action == "remove") {
+            if (SysfsBattery *b = m_batteries.take(name)) {
+                deviceRemoved(b->udi());
+            }
+        } else if (action == "add" && !m_batteries.contains(name)) {
+            addBattery(name);
+        } else {
+            // the AC adapter going on or off changes the state of all the batteries
+            for (SysfsBattery *b: m_batteries) {
+                b->refresh();
+            }
+        }
+        return;
+    }
+
+    if (subsystem != "block") {
+        return;
+    }
+
+    if (action == "remove") {
+        removeDevice(name);
+    } else if (action == "add" || action == "change") {
+        // udev sends a change also when a device is closed after being written to, so
+        // keep the same device and only add or remove it when its file system comes or goes
+        if (SysfsDevice *d = m_devices.value(name)) {
+            if (!updateDevice(name, d)) {
+                removeDevice(name);
+            }
+        } else {
+            addDevice(name);
+        }
+    }
+}
+
+void SysfsBackend::updateMounts()
+{
+    QFile file(QStringLiteral("/proc/self/mountinfo"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // the lines are "id parent major:minor root mountpoint options [optional fields] - fstype source options"
+    m_mounted.clear();
+    foreach (const QByteArray &line, file.readAll().split('\n')) {
+        QList<QByteArray> fields = line.split(' ');
+        int sep = fields.indexOf("-");
+        if (fields.size() < 3 || sep < 0 || sep + 2 >= fields.size()) {
+            continue;
+        }
+        m_mounted.insert(fields.at(2));
+        m_mounted.insert(fields.at(sep + 2));
+    }
+
+    for (SysfsDevice *d: m_devices) {
+        if (d->type() == Device::Type::Storage) {
+            d->setMounted(m_mounted.contains(d->devNum()) || m_mounted.contains(d->udi().toUtf8()));
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYSFSBACKEND_H
+#define SYSFSBACKEND_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "hardwareservice.h"
+#include "ueventmonitor.h"
+
+class QSocketNotifier;
+
+class SysfsDevice : public Device
+{
+public:
+    SysfsDevice(const QString &udi, const QByteArray &devNum);
+
+    bool umount() override;
+    bool mount() override;
+    bool isMounted() const override { return m_mounted; }
+
+    QByteArray devNum() const { return m_devNum; }
+    void setMounted(bool mounted);
+
+private:
+    QByteArray m_devNum;
+    bool m_mounted;
+};
+
+/*
+ * A battery in /sys/class/power_supply. It is read again when udev says something
+ * changed, e.g. the AC adapter was plugged, and otherwise every now and then,
+ * less often the slower the battery is being charged or discharged.
+ */
+class SysfsBattery : public Battery
+{
+public:
+    static const int MinInterval = 60000;
+    static const int MaxInterval = 600000;
+
+    SysfsBattery(const QString &name);
+
+    void refresh();
+
+private:
+    QString m_path;
+    QTimer m_timer;
+    qint64 m_lastEnergy;
+    QElapsedTimer m_lastTime;
+    // the smoothed rate of change of the energy, in energy units per hour
+    double m_rate;
+    ChargeState m_lastState;
+};
+
+/*
+ * Finds the block devices in sysfs and their file systems in the udev database,
+ * without running any process. New and removed devices come from the udev
+ * events, and the mounts are tracked watching /proc/self/mountinfo.
+ * The batteries are read from /sys/class/power_supply.
+ */
+class SysfsBackend : public QObject, public HardwareManager::Backend
+{
+    Q_OBJECT
+public:
+    static SysfsBackend *create(HardwareManager *hw);
+    ~SysfsBackend();
+
+private:
+    SysfsBackend(HardwareManager *hw);
+
+    void addDevice(const QString &name);
+    bool updateDevice(const QString &name, SysfsDevice *device);
+    void addBattery(const QString &name);
+    void removeDevice(const QString &name);
+    void uevent(const UeventMonitor::Properties &properties);
+    void updateMounts();
+
+    UeventMonitor *m_monitor;
+    int m_mountsFd;
+    QSocketNotifier *m_mountsNotifier;
+    QHash<QString, SysfsDevice *> m_devices;
+    QHash<QString, SysfsBattery *> m_batteries;
+    // the mounted devices, both by major:minor and by path
+    QSet<QByteArray> m_mounted;
+};
+
+#endif
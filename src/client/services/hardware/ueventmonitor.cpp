@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+#include <QSocketNotifier>
+#include <QtEndian>
+#include <QDebug>
+
+#include "ueventmonitor.h"
+
+// the multicast group udev sends its events to, the kernel uses 1
+static const int UdevGroup = 2;
+
+UeventMonitor::UeventMonitor(QObject *parent)
+             : QObject(parent)
+             , m_fd(socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT))
+             , m_notifier(nullptr)
+{
+    if (m_fd < 0) {
+        qWarning("UeventMonitor: cannot create the netlink socket: %m");
+        return;
+    }
+
+    // we want to know who sent the messages, see receive()
+    int on = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_PASSCRED, &on, sizeof(on));
+
+    sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = UdevGroup;
+    if (bind(m_fd, (sockaddr *)&addr, sizeof(addr)) < 0) {
+        qWarning("UeventMonitor: cannot bind the netlink socket: %m");
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &UeventMonitor::receive);
+}
+
+UeventMonitor::~UeventMonitor()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+void UeventMonitor::receive()
+{
+    char buf[8192];
+    char control[CMSG_SPACE(sizeof(ucred))];
+    while (true) {
+        iovec iov = { buf, sizeof(buf) };
+        msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t len = recvmsg(m_fd, &msg, 0);
+        if (len <= 0) {
+            return;
+        }
+
+        // anyone can send messages to the group, only trust the ones coming from root
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if (!cmsg || cmsg->cmsg_type != SCM_CREDENTIALS || reinterpret_cast<ucred *>(CMSG_DATA(cmsg))->uid != 0) {
+            continue;
+        }
+
+        // udev messages start with a header, "libudev\0" followed by the magic number, the size
+        // of the header and the offset and size of the properties
+        if (len < 24 || memcmp(buf, "libudev", 8) != 0 || qFromBigEndian<quint32>((const uchar *)buf + 8) != 0xfeedcafe) {
+            continue;
+        }
+        quint32 offset = *reinterpret_cast<const quint32 *>(buf + 16);
+        quint32 size = *reinterpret_cast<const quint32 *>(buf + 20);
+        if (offset > (size_t)len || size > len - offset) {
+            continue;
+        }
+
+        Properties properties;
+        const char *p = buf + offset;
+        const char *end = p + size;
+        while (p < end) {
+            size_t l = strnlen(p, end - p);
+            const char *eq = static_cast<const char *>(memchr(p, '=', l));
+            if (eq) {
+                properties.insert(QByteArray(p, eq - p), QByteArray(eq + 1, p + l - eq - 1));
+            }
+            p += l + 1;
+        }
+
+        if (properties.contains("ACTION") && properties.contains("SUBSYSTEM") && properties.contains("DEVPATH")) {
+            emit uevent(properties);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UEVENTMONITOR_H
+#define UEVENTMONITOR_H
+
+#include <QObject>
+#include <QHash>
+
+class QSocketNotifier;
+
+/*
+ * Listens to the device events sent by udev on the netlink socket, after it has
+ * processed them, so that its database is already up to date when we get them.
+ */
+class UeventMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    typedef QHash<QByteArray, QByteArray> Properties;
+
+    explicit UeventMonitor(QObject *parent = nullptr);
+    ~UeventMonitor();
+
+    bool isValid() const { return m_fd >= 0; }
+
+signals:
+    /**
+     * The properties always contain ACTION, SUBSYSTEM and DEVPATH.
+     */
+    void uevent(const UeventMonitor::Properties &properties);
+
+private:
+    void receive();
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+};
+
+#endif
@@ -39,10 +39,12 @@ CliBackend *CliBackend::create()
 
 void CliBackend::poweroff()
 {
-    QProcess::execute(QStringLiteral("shutdown -h now"));
+    QProcess::startDetached(QStringLiteral("shutdown -h now"));
+    emit done();
 }
 
 void CliBackend::reboot()
 {
-    QProcess::execute(QStringLiteral("shutdown -r now"));
+    QProcess::startDetached(QStringLiteral("shutdown -r now"));
+    emit done();
 }
@@ -74,12 +74,20 @@ LogindBackend *LogindBackend::create()
 
 void LogindBackend::poweroff()
 {
-    m_interface->call(QStringLiteral("PowerOff"), true);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_interface->asyncCall(QStringLiteral("PowerOff"), true), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *w) {
+        w->deleteLater();
+        emit done();
+    });
 }
 
 void LogindBackend::reboot()
 {
-    m_interface->call(QStringLiteral("Reboot"), true);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_interface->asyncCall(QStringLiteral("Reboot"), true), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *w) {
+        w->deleteLater();
+        emit done();
+    });
 }
 
 void LogindBackend::takeSleepLock()
@@ -124,6 +124,7 @@ LoginManager::LoginManager(QObject *p)
             , m_authenticator(new PamAuthenticator)
             , m_authenticatorThread(new QThread)
             , m_busy(false)
+            , m_ending(false)
 {
     qRegisterMetaType<Result>();
 
@@ -166,47 +167,82 @@ void LoginManager::abort()
 
 void LoginManager::logOut()
 {
-    Client::client()->quit();
+    endSession(Action::LogOut);
 }
 
 void LoginManager::poweroff()
 {
-    Client::client()->quit();
-    if (m_backend) {
-        m_backend->poweroff();
-    }
+    endSession(Action::Poweroff);
 }
 
 void LoginManager::reboot()
 {
-    Client::client()->quit();
-    if (m_backend) {
-        m_backend->reboot();
+    endSession(Action::Reboot);
+}
+
+// First the other clients are asked to quit, all together, then once they are gone
+// or the timeout expired the system is asked to power off or reboot, and only then
+// the compositor quits, taking down the shell and Xwayland with it.
+void LoginManager::endSession(Action action)
+{
+    if (m_ending) {
+        return;
     }
+    m_ending = true;
+    m_endTimer.start();
+    qDebug() << "Ending the session...";
+
+    Client::client()->endSession(ClientsTimeout, [this, action]() {
+        qDebug() << "Session end: clients done after" << m_endTimer.elapsed() << "ms";
+        if (action == Action::LogOut || !m_backend) {
+            finishSession();
+            return;
+        }
+
+        connect(m_backend, &LoginManagerBackend::done, this, &LoginManager::finishSession);
+        QTimer::singleShot(BackendTimeout, this, &LoginManager::finishSession);
+        if (action == Action::Poweroff) {
+            m_backend->poweroff();
+        } else {
+            m_backend->reboot();
+        }
+    });
+}
+
+void LoginManager::finishSession()
+{
+    if (!m_ending) {
+        return;
+    }
+    m_ending = false;
+    qDebug() << "Session end: quitting after" << m_endTimer.elapsed() << "ms";
+    Client::client()->quit();
 }
 
+// the handlers of the signals call requestHandled() if they want to take care of the
+// request themselves, e.g. showing a countdown, otherwise we go ahead right away
 void LoginManager::requestLogOut()
 {
     m_request = &LoginManager::logOut;
     m_requestHandled = false;
-    QTimer::singleShot(200, this, &LoginManager::doRequest);
     emit logOutRequested();
+    QMetaObject::invokeMethod(this, "doRequest", Qt::QueuedConnection);
 }
 
 void LoginManager::requestPoweroff()
 {
     m_request = &LoginManager::poweroff;
     m_requestHandled = false;
-    QTimer::singleShot(200, this, &LoginManager::doRequest);
     emit poweroffRequested();
+    QMetaObject::invokeMethod(this, "doRequest", Qt::QueuedConnection);
 }
 
 void LoginManager::requestReboot()
 {
     m_request = &LoginManager::reboot;
     m_requestHandled = false;
-    QTimer::singleShot(200, this, &LoginManager::doRequest);
     emit rebootRequested();
+    QMetaObject::invokeMethod(this, "doRequest", Qt::QueuedConnection);
 }
 
 void LoginManager::requestHandled()
@@ -21,6 +21,7 @@
 #define LOGINSERVICE_H
 
 #include <QQmlExtensionPlugin>
+#include <QElapsedTimer>
 
 class QJSValue;
 
@@ -40,6 +41,9 @@ class LoginManagerBackend : public QObject
 public:
     virtual ~LoginManagerBackend() {}
 
+    /**
+     * Ask the system to power off or reboot, emitting done() when the request was sent.
+     */
     virtual void poweroff() = 0;
     virtual void reboot() = 0;
     virtual void locked() {}
@@ -48,6 +52,7 @@ public:
 signals:
     void requestLock();
     void requestUnlock();
+    void done();
 };
 
 class LoginManager : public QObject
@@ -93,12 +98,25 @@ private slots:
     void doRequest();
 
 private:
+    enum class Action {
+        LogOut,
+        Poweroff,
+        Reboot
+    };
+    static const int ClientsTimeout = 5000;
+    static const int BackendTimeout = 5000;
+
+    void endSession(Action action);
+    void finishSession();
+
     LoginManagerBackend *m_backend;
     void (LoginManager::*m_request)();
     bool m_requestHandled;
     PamAuthenticator *m_authenticator;
     QThread *m_authenticatorThread;
     bool m_busy;
+    bool m_ending;
+    QElapsedTimer m_endTimer;
 };
 
 #endif
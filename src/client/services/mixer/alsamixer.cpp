@@ -17,6 +17,8 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QSocketNotifier>
+
 #include "alsamixer.h"
 #include "client.h"
 
@@ -26,6 +28,12 @@ static const char *selem_name = "Master";
 AlsaMixer::AlsaMixer(Mixer *m)
          : Backend()
          , m_mixer(m)
+         , m_handle(nullptr)
+         , m_elem(nullptr)
+         , m_min(0)
+         , m_max(0)
+         , m_volume(0)
+         , m_muted(false)
 {
 }
 
@@ -36,27 +44,103 @@ AlsaMixer *AlsaMixer::create(Mixer *m)
         return nullptr;
     }
 
-    snd_mixer_open(&alsa->m_handle, 0);
+    if (snd_mixer_open(&alsa->m_handle, 0) < 0) {
+        alsa->m_handle = nullptr;
+        delete alsa;
+        return nullptr;
+    }
     snd_mixer_attach(alsa->m_handle, card);
     snd_mixer_selem_register(alsa->m_handle, NULL, NULL);
     snd_mixer_load(alsa->m_handle);
 
-    snd_mixer_selem_id_alloca(&alsa->m_sid);
-    snd_mixer_selem_id_set_index(alsa->m_sid, 0);
-    snd_mixer_selem_id_set_name(alsa->m_sid, selem_name);
-    alsa->m_elem = snd_mixer_find_selem(alsa->m_handle, alsa->m_sid);
+    snd_mixer_selem_id_t *sid;
+    snd_mixer_selem_id_alloca(&sid);
+    snd_mixer_selem_id_set_index(sid, 0);
+    snd_mixer_selem_id_set_name(sid, selem_name);
+    alsa->m_elem = snd_mixer_find_selem(alsa->m_handle, sid);
     if (!alsa->m_elem) {
         delete alsa;
         return nullptr;
     }
 
     snd_mixer_selem_get_playback_volume_range(alsa->m_elem, &alsa->m_min, &alsa->m_max);
+    snd_mixer_elem_set_callback_private(alsa->m_elem, alsa);
+    snd_mixer_elem_set_callback(alsa->m_elem, elemCallback);
+    alsa->update();
+    alsa->watch();
     return alsa;
 }
 
 AlsaMixer::~AlsaMixer()
 {
-    snd_mixer_close(m_handle);
+    for (QSocketNotifier *n: m_notifiers) {
+        delete n;
+    }
+    if (m_handle) {
+        snd_mixer_close(m_handle);
+    }
+}
+
+void AlsaMixer::watch()
+{
+    int count = snd_mixer_poll_descriptors_count(m_handle);
+    if (count <= 0) {
+        return;
+    }
+
+    std::vector<pollfd> fds(count);
+    count = snd_mixer_poll_descriptors(m_handle, fds.data(), count);
+    for (int i = 0; i < count; ++i) {
+        QSocketNotifier *notifier = new QSocketNotifier(fds[i].fd, QSocketNotifier::Read);
+        QObject::connect(notifier, &QSocketNotifier::activated, m_mixer, [this]() { handleEvents(); });
+        m_notifiers.push_back(notifier);
+    }
+}
+
+void AlsaMixer::handleEvents()
+{
+    // this calls elemCallback for every element that changed
+    if (snd_mixer_handle_events(m_handle) < 0) {
+        qWarning("AlsaMixer: failed to handle the mixer events");
+    }
+}
+
+int AlsaMixer::elemCallback(snd_mixer_elem_t *elem, unsigned int mask)
+{
+    AlsaMixer *alsa = static_cast<AlsaMixer *>(snd_mixer_elem_get_callback_private(elem));
+    if (mask == SND_CTL_EVENT_MASK_REMOVE) {
+        // the card went away, keep the last known state around
+        alsa->m_elem = nullptr;
+        for (QSocketNotifier *n: alsa->m_notifiers) {
+            n->setEnabled(false);
+        }
+    } else if (mask & SND_CTL_EVENT_MASK_VALUE) {
+        alsa->update();
+    }
+    return 0;
+}
+
+void AlsaMixer::update()
+{
+    if (!m_elem) {
+        return;
+    }
+
+    long vol = 0;
+    snd_mixer_selem_get_playback_volume(m_elem, SND_MIXER_SCHN_MONO, &vol);
+    int on = 1;
+    if (snd_mixer_selem_has_playback_switch(m_elem)) {
+        snd_mixer_selem_get_playback_switch(m_elem, SND_MIXER_SCHN_MONO, &on);
+    }
+
+    if (vol != m_volume) {
+        m_volume = vol;
+        emit m_mixer->masterChanged();
+    }
+    if (!on != m_muted) {
+        m_muted = !on;
+        emit m_mixer->mutedChanged();
+    }
 }
 
 void AlsaMixer::getBoundaries(int *min, int *max) const
@@ -67,26 +151,26 @@ void AlsaMixer::getBoundaries(int *min, int *max) const
 
 void AlsaMixer::setRawVol(int volume)
 {
-    snd_mixer_selem_set_playback_volume_all(m_elem, volume);
-    emit m_mixer->masterChanged();
+    if (m_elem) {
+        snd_mixer_selem_set_playback_volume_all(m_elem, volume);
+        update();
+    }
 }
 
 int AlsaMixer::rawVol() const
 {
-    long vol;
-    snd_mixer_selem_get_playback_volume(m_elem, SND_MIXER_SCHN_UNKNOWN, &vol);
-    return vol;
+    return m_volume;
 }
 
 bool AlsaMixer::muted() const
 {
-    int mute;
-    snd_mixer_selem_get_playback_switch(m_elem, SND_MIXER_SCHN_UNKNOWN, &mute);
-    return !mute;
+    return m_muted;
 }
 
 void AlsaMixer::setMuted(bool muted)
 {
-    snd_mixer_selem_set_playback_switch_all(m_elem, !muted);
-    emit m_mixer->mutedChanged();
+    if (m_elem) {
+        snd_mixer_selem_set_playback_switch_all(m_elem, !muted);
+        update();
+    }
 }
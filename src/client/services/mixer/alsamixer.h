@@ -20,10 +20,18 @@
 #ifndef ALSAMIXER_H
 #define ALSAMIXER_H
 
+#include <vector>
+
 #include <alsa/asoundlib.h>
 
 #include "mixerservice.h"
 
+class QSocketNotifier;
+
+/*
+ * The volume and the mute state are cached, and updated when ALSA
+ * tells us they changed, watching the mixer poll descriptors.
+ */
 class AlsaMixer : public Backend
 {
 public:
@@ -40,13 +48,19 @@ public:
 
 private:
     AlsaMixer(Mixer *mixer);
+    void watch();
+    void handleEvents();
+    void update();
+    static int elemCallback(snd_mixer_elem_t *elem, unsigned int mask);
 
     Mixer *m_mixer;
     snd_mixer_t *m_handle;
-    snd_mixer_selem_id_t *m_sid;
     snd_mixer_elem_t *m_elem;
     long m_min;
     long m_max;
+    long m_volume;
+    bool m_muted;
+    std::vector<QSocketNotifier *> m_notifiers;
 };
 
 #endif
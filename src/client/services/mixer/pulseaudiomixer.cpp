@@ -17,6 +17,8 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string>
+
 #include <QDebug>
 
 #include <pulse/glib-mainloop.h>
@@ -27,7 +29,8 @@
 
 struct Sink
 {
-    Sink() : index(0), volume{}, muted(false) {}
+    Sink() : index(PA_INVALID_INDEX), volume{}, muted(false) {}
+    std::string name;
     uint32_t index;
     pa_cvolume volume;
     bool muted;
@@ -37,7 +40,12 @@ PulseAudioMixer::PulseAudioMixer(Mixer *m)
                : Backend()
                , m_mixer(m)
                , m_sink(new Sink)
+               , m_pendingChanges(0)
 {
+    // a burst of change events, e.g. when scrolling on the volume, results in a single fetch
+    m_fetchTimer.setSingleShot(true);
+    m_fetchTimer.setInterval(16);
+    QObject::connect(&m_fetchTimer, &QTimer::timeout, m_mixer, [this]() { fetchSink(); });
 }
 
 PulseAudioMixer::~PulseAudioMixer()
@@ -98,11 +106,9 @@ void PulseAudioMixer::contextStateCallback(pa_context *c)
             pa_context_set_subscribe_callback(c, [](pa_context *c, pa_subscription_event_type_t t, uint32_t index, void *ud) {
                 static_cast<PulseAudioMixer *>(ud)->subscribeCallback(c, t, index);
             }, this);
-            pa_context_subscribe(c, PA_SUBSCRIPTION_MASK_SINK, nullptr, nullptr);
-
-            pa_context_get_sink_info_list(c, [](pa_context *c, const pa_sink_info *i, int eol, void *ud) {
-                static_cast<PulseAudioMixer *>(ud)->sinkCallback(c, i, eol);
-            }, this);
+            pa_context_subscribe(c, (pa_subscription_mask_t)(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SERVER),
+                                 nullptr, nullptr);
+            fetchServerInfo();
             break;
 
         case PA_CONTEXT_TERMINATED:
@@ -121,15 +127,79 @@ void PulseAudioMixer::subscribeCallback(pa_context *c, pa_subscription_event_typ
 {
     switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) {
         case PA_SUBSCRIPTION_EVENT_SINK:
-            pa_context_get_sink_info_list(c, [](pa_context *c, const pa_sink_info *i, int eol, void *ud) {
-                static_cast<PulseAudioMixer *>(ud)->sinkCallback(c, i, eol);
-            }, this);
+            // the other sinks are of no interest
+            if (index != m_sink->index) {
+                break;
+            }
+            if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+                // the server will pick another default sink
+                m_sink->index = PA_INVALID_INDEX;
+                fetchServerInfo();
+            } else if (!m_fetchTimer.isActive()) {
+                m_fetchTimer.start();
+            }
+            break;
+        case PA_SUBSCRIPTION_EVENT_SERVER:
+            // the default sink may have changed
+            fetchServerInfo();
             break;
         default:
             break;
     }
 }
 
+void PulseAudioMixer::fetchServerInfo()
+{
+    pa_operation *op = pa_context_get_server_info(m_context, [](pa_context *, const pa_server_info *i, void *ud) {
+        static_cast<PulseAudioMixer *>(ud)->serverInfoCallback(i);
+    }, this);
+    if (op) {
+        pa_operation_unref(op);
+    }
+}
+
+void PulseAudioMixer::serverInfoCallback(const pa_server_info *i)
+{
+    if (!i || !i->default_sink_name) {
+        return;
+    }
+
+    if (m_sink->name != i->default_sink_name || m_sink->index == PA_INVALID_INDEX) {
+        // the index and the changes in flight belong to the old sink, fetch the new one by name
+        m_sink->name = i->default_sink_name;
+        m_sink->index = PA_INVALID_INDEX;
+        m_pendingChanges = 0;
+        m_fetchTimer.stop();
+        fetchSink();
+    }
+}
+
+void PulseAudioMixer::fetchSink()
+{
+    auto callback = [](pa_context *c, const pa_sink_info *i, int eol, void *ud) {
+        static_cast<PulseAudioMixer *>(ud)->sinkCallback(c, i, eol);
+    };
+
+    pa_operation *op;
+    if (m_sink->index != PA_INVALID_INDEX) {
+        op = pa_context_get_sink_info_by_index(m_context, m_sink->index, callback, this);
+    } else {
+        op = pa_context_get_sink_info_by_name(m_context, m_sink->name.c_str(), callback, this);
+    }
+    if (op) {
+        pa_operation_unref(op);
+    }
+}
+
+void PulseAudioMixer::changeDone()
+{
+    // once the server caught up with us get the real state, which may be
+    // different if someone else changed it in the meantime
+    if (m_pendingChanges > 0 && --m_pendingChanges == 0) {
+        fetchSink();
+    }
+}
+
 void PulseAudioMixer::sinkCallback(pa_context *c, const pa_sink_info *i, int eol)
 {
     if (eol < 0) {
@@ -144,13 +214,25 @@ void PulseAudioMixer::sinkCallback(pa_context *c, const pa_sink_info *i, int eol
         return;
     }
 
+    // a reply for a sink that is not the default anymore
+    if (m_sink->name != i->name) {
+        return;
+    }
+
     m_sink->index = i->index;
+    // the server state may be older than our own, it will be fetched again later
+    if (m_pendingChanges > 0) {
+        return;
+    }
+
     if (m_sink->muted != (bool)i->mute) {
         m_sink->muted = (bool)i->mute;
         emit m_mixer->mutedChanged();
     }
-    m_sink->volume = i->volume;
-    emit m_mixer->masterChanged();
+    if (!pa_cvolume_equal(&m_sink->volume, &i->volume)) {
+        m_sink->volume = i->volume;
+        emit m_mixer->masterChanged();
+    }
 }
 
 void PulseAudioMixer::cleanup()
@@ -171,9 +253,19 @@ void PulseAudioMixer::setRawVol(int vol)
         return;
     }
 
-    setMuted(false);
+    if (m_sink->muted) {
+        setMuted(false);
+    }
     pa_cvolume_set(&m_sink->volume, m_sink->volume.channels, vol);
-    pa_context_set_sink_volume_by_index(m_context, m_sink->index, &m_sink->volume, nullptr, nullptr);
+    emit m_mixer->masterChanged();
+
+    pa_operation *op = pa_context_set_sink_volume_by_index(m_context, m_sink->index, &m_sink->volume, [](pa_context *, int, void *ud) {
+        static_cast<PulseAudioMixer *>(ud)->changeDone();
+    }, this);
+    if (op) {
+        ++m_pendingChanges;
+        pa_operation_unref(op);
+    }
 }
 
 int PulseAudioMixer::rawVol() const
@@ -188,5 +280,20 @@ bool PulseAudioMixer::muted() const
 
 void PulseAudioMixer::setMuted(bool muted)
 {
-    pa_context_set_sink_mute_by_index(m_context, m_sink->index, muted, nullptr, nullptr);
+    if (m_sink->index == PA_INVALID_INDEX) {
+        return;
+    }
+
+    if (m_sink->muted != muted) {
+        m_sink->muted = muted;
+        emit m_mixer->mutedChanged();
+    }
+
+    pa_operation *op = pa_context_set_sink_mute_by_index(m_context, m_sink->index, muted, [](pa_context *, int, void *ud) {
+        static_cast<PulseAudioMixer *>(ud)->changeDone();
+    }, this);
+    if (op) {
+        ++m_pendingChanges;
+        pa_operation_unref(op);
+    }
 }
@@ -22,12 +22,20 @@
 
 #include <pulse/pulseaudio.h>
 
+#include <QTimer>
+
 #include "mixerservice.h"
 
 struct pa_glib_mainloop;
 
 struct Sink;
 
+/*
+ * Tracks the default sink only. The server tells us which one it is, and
+ * the sink is fetched again when it changes, coalescing the bursts of change
+ * events. The local changes are applied right away without waiting for the
+ * server to confirm them.
+ */
 class PulseAudioMixer : public Backend
 {
 public:
@@ -47,6 +55,10 @@ private:
     void contextStateCallback(pa_context *c);
     void subscribeCallback(pa_context *c, pa_subscription_event_type_t t, uint32_t index);
     void sinkCallback(pa_context *c, const pa_sink_info *i, int eol);
+    void serverInfoCallback(const pa_server_info *i);
+    void fetchServerInfo();
+    void fetchSink();
+    void changeDone();
     void cleanup();
 
     Mixer *m_mixer;
@@ -54,6 +66,9 @@ private:
     pa_mainloop_api *m_mainloopApi;
     pa_context *m_context;
     Sink *m_sink;
+    QTimer m_fetchTimer;
+    // the local changes not yet acknowledged by the server
+    int m_pendingChanges;
 };
 
 #endif
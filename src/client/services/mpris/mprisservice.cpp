@@ -30,10 +30,11 @@
 
 #define DBUS_SERVICE QStringLiteral("org.freedesktop.DBus")
 #define MPRIS_PATH QStringLiteral("/org/mpris/MediaPlayer2")
-#define MPRIS_INTERFACE QStringLiteral("org.mpris.MediaPlayer2")
 #define MPRIS_PLAYER_INTERFACE QStringLiteral("org.mpris.MediaPlayer2.Player")
 #define DBUS_PROPERTIES_INTERFACE QStringLiteral("org.freedesktop.DBus.Properties")
 
+#define MPRIS_SERVICE_PREFIX QStringLiteral("org.mpris.MediaPlayer2.")
+
 void MprisPlugin::registerTypes(const char *uri)
 {
     qmlRegisterType<Mpris>(uri, 1, 0, "Mpris");
@@ -43,13 +44,8 @@ Mpris::Mpris(QObject *p)
             : QObject(p)
             , m_valid(false)
             , m_pid(0)
-            , m_playbackStatus(PlaybackStatus::Stopped)
-            , m_trackLength(0)
-            , m_trackPosition(0)
-            , m_rate(1)
 {
-    m_posTimer.setInterval(1000);
-    connect(&m_posTimer, &QTimer::timeout, this, &Mpris::updatePos);
+    connect(MprisPlayers::instance(), &MprisPlayers::playersChanged, this, &Mpris::selectPlayer);
 }
 
 Mpris::~Mpris()
@@ -71,264 +67,372 @@ void Mpris::setPid(quint64 pid)
     if (m_pid != pid) {
         m_pid = pid;
         emit targetChanged();
-        setValid(false);
-        checkConnection();
+        selectPlayer();
     }
 }
 
-#define CALL(method) \
-    DBusInterface iface(m_service, MPRIS_PATH, MPRIS_PLAYER_INTERFACE); \
-    iface.asyncCall(QStringLiteral(method))
+Mpris::PlaybackStatus Mpris::playbackStatus() const
+{
+    return m_player ? m_player->playbackStatus() : PlaybackStatus::Stopped;
+}
 
-void Mpris::playPause()
+QString Mpris::trackTitle() const
 {
-    CALL("PlayPause");
+    return m_player ? m_player->trackTitle() : QString();
 }
 
-void Mpris::stop()
+quint32 Mpris::trackLength() const
 {
-    CALL("Stop");
+    return m_player ? m_player->trackLength() : 0;
 }
 
-void Mpris::previous()
+quint32 Mpris::trackPosition() const
 {
-    CALL("Previous");
+    return m_player ? m_player->trackPosition() : 0;
 }
 
-void Mpris::next()
+double Mpris::rate() const
 {
-    CALL("Next");
+    return m_player ? m_player->rate() : 1.;
 }
 
-void Mpris::checkConnection()
+void Mpris::selectPlayer()
 {
-    if (m_valid) {
-        QDBusConnection::sessionBus().disconnect(m_service, MPRIS_PATH, DBUS_PROPERTIES_INTERFACE,
-                                                 QStringLiteral("PropertiesChanged"),
-                                                 this, SLOT(propertiesChanged(QString, QMap<QString, QVariant>, QStringList)));
+    MprisPlayer *player = m_pid ? MprisPlayers::instance()->player(m_pid) : nullptr;
+    if (player == m_player && m_valid == (player != nullptr)) {
+        return;
     }
 
-    DBusInterface iface(DBUS_SERVICE, QStringLiteral("/"), DBUS_SERVICE);
-    QDBusPendingCall call = iface.asyncCall(QStringLiteral("ListNames"));
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
-    watcher->connect(watcher, &QDBusPendingCallWatcher::finished, [this](QDBusPendingCallWatcher *watcher) {
-        watcher->deleteLater();
-        QDBusPendingReply<QStringList> reply = *watcher;
+    if (m_player) {
+        disconnect(m_player, nullptr, this, nullptr);
+    }
+    m_player = player;
+    if (m_player) {
+        connect(m_player, &MprisPlayer::playbackStatusChanged, this, &Mpris::playbackStatusChanged);
+        connect(m_player, &MprisPlayer::trackTitleChanged, this, &Mpris::trackTitleChanged);
+        connect(m_player, &MprisPlayer::trackLengthChanged, this, &Mpris::trackLengthChanged);
+        connect(m_player, &MprisPlayer::trackPositionChanged, this, &Mpris::trackPositionChanged);
+        connect(m_player, &MprisPlayer::rateChanged, this, &Mpris::rateChanged);
+    }
 
-        if (reply.isError()) {
-            qDebug("Failed to get the list of DBus services.");
-        } else {
-            QStringList services = reply.value();
-            checkServices(services);
-        }
-    });
+    if (m_valid != (player != nullptr)) {
+        m_valid = player != nullptr;
+        emit validChanged();
+    }
+    emit playbackStatusChanged();
+    emit trackTitleChanged();
+    emit trackLengthChanged();
+    emit trackPositionChanged();
+    emit rateChanged();
 }
 
-void Mpris::checkServices(const QStringList &services)
+void Mpris::call(const char *method)
 {
-    DBusInterface iface(DBUS_SERVICE, QStringLiteral("/"), DBUS_SERVICE);
-    foreach (const QString &service, services) {
-        QDBusPendingCall call = iface.asyncCall(QStringLiteral("GetConnectionUnixProcessID"), service);
-        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
-        watcher->connect(watcher, &QDBusPendingCallWatcher::finished, [this, service](QDBusPendingCallWatcher *watcher) {
-            watcher->deleteLater();
-            QDBusPendingReply<quint32> reply = *watcher;
-
-            if (reply.isError()) {
-                qDebug("Unable to get the pid of service %s.", qPrintable(service));
-            } else {
-                quint32 p = reply.value();
-                if (p == m_pid) {
-                    checkService(service);
-                }
-            }
-        });
+    if (m_player) {
+        DBusInterface iface(m_player->service(), MPRIS_PATH, MPRIS_PLAYER_INTERFACE);
+        iface.asyncCall(QLatin1String(method));
     }
 }
 
-static QDBusPendingCall getProperty(const QString &service, const QString &path,
-                                    const QString &interface, const QString &property)
+void Mpris::playPause()
+{
+    call("PlayPause");
+}
+
+void Mpris::stop()
 {
-    DBusInterface iface(service, path, DBUS_PROPERTIES_INTERFACE);
-    return iface.asyncCall(QStringLiteral("Get"), interface, property);
+    call("Stop");
 }
 
-void Mpris::checkService(const QString &service)
+void Mpris::previous()
 {
-    QDBusPendingCall call = ::getProperty(service, MPRIS_PATH, MPRIS_INTERFACE, QStringLiteral("Identity"));
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
-    watcher->connect(watcher, &QDBusPendingCallWatcher::finished, [this, service](QDBusPendingCallWatcher *watcher) {
+    call("Previous");
+}
+
+void Mpris::next()
+{
+    call("Next");
+}
+
+
+
+MprisPlayer::MprisPlayer(const QString &service, quint32 pid, QObject *parent)
+           : QObject(parent)
+           , m_service(service)
+           , m_pid(pid)
+           , m_ready(false)
+           , m_playbackStatus(Mpris::PlaybackStatus::Stopped)
+           , m_trackLength(0)
+           , m_position(0)
+           , m_rate(1)
+           , m_lastActivity(0)
+{
+    m_positionTime.start();
+
+    QDBusConnection::sessionBus().connect(service, MPRIS_PATH, DBUS_PROPERTIES_INTERFACE,
+                                          QStringLiteral("PropertiesChanged"),
+                                          this, SLOT(propertiesChanged(QString, QVariantMap, QStringList)));
+    QDBusConnection::sessionBus().connect(service, MPRIS_PATH, MPRIS_PLAYER_INTERFACE,
+                                          QStringLiteral("Seeked"),
+                                          this, SLOT(seeked(qint64)));
+    getAll();
+}
+
+void MprisPlayer::getAll()
+{
+    DBusInterface iface(m_service, MPRIS_PATH, DBUS_PROPERTIES_INTERFACE);
+    QDBusPendingCall call = iface.asyncCall(QStringLiteral("GetAll"), MPRIS_PLAYER_INTERFACE);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
         watcher->deleteLater();
-        QDBusPendingReply<QVariant> reply = *watcher;
-        if (m_valid) {
+        QDBusPendingReply<QVariantMap> reply = *watcher;
+
+        if (reply.isError()) {
+            qDebug("%s is not a valid mpris service.", qPrintable(m_service));
             return;
         }
 
-        if (reply.isError()) {
-            qDebug("%s is not a valid mpris service.", qPrintable(service));
-        } else {
-            setValid(true);
-            m_service = service;
-            qDebug("Found %s at %s.", qPrintable(reply.value().toString()), qPrintable(service));
-
-            QDBusConnection::sessionBus().connect(service, MPRIS_PATH, DBUS_PROPERTIES_INTERFACE,
-                                                QStringLiteral("PropertiesChanged"),
-                                                this, SLOT(propertiesChanged(QString, QMap<QString, QVariant>, QStringList)));
-            QDBusConnection::sessionBus().connect(service, MPRIS_PATH, MPRIS_PLAYER_INTERFACE,
-                                                  QStringLiteral("Seeked"),
-                                                  this, SLOT(seeked(qint64)));
-            getMetadata();
-            getPosition();
-            getPlaybackStatus();
-            getRate();
+        update(reply.value());
+        if (!m_ready) {
+            m_ready = true;
+            qDebug("Found a mpris player at %s.", qPrintable(m_service));
+            emit ready();
         }
     });
 }
 
-inline void Mpris::setValid(bool v)
-{
-    if (m_valid != v) {
-        m_valid = v;
-        emit validChanged();
-    }
-}
-
-void Mpris::getProperty(const QString &property, const std::function<void (const QVariant &v)> &func)
+// the position is not notified with PropertiesChanged, so get it again when
+// something happens that may change it
+void MprisPlayer::getPosition()
 {
-    QDBusPendingCall call = ::getProperty(m_service, MPRIS_PATH, MPRIS_PLAYER_INTERFACE, property);
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
-    watcher->connect(watcher, &QDBusPendingCallWatcher::finished, [property, func](QDBusPendingCallWatcher *watcher) {
+    DBusInterface iface(m_service, MPRIS_PATH, DBUS_PROPERTIES_INTERFACE);
+    QDBusPendingCall call = iface.asyncCall(QStringLiteral("Get"), MPRIS_PLAYER_INTERFACE, QStringLiteral("Position"));
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
         watcher->deleteLater();
         QDBusPendingReply<QVariant> reply = *watcher;
 
         if (reply.isError()) {
-            qDebug("Mpris: failed to retrieve property '%s'.", qPrintable(property));
-            func(QVariant());
+            qDebug("Mpris: failed to retrieve the position of %s.", qPrintable(m_service));
         } else {
-            func(reply.value());
+            setPosition(reply.value().toLongLong() / 1000);
         }
     });
 }
 
-void Mpris::getMetadata()
+void MprisPlayer::update(const QVariantMap &properties)
 {
-    getProperty(QStringLiteral("Metadata"), [this](const QVariant &v) {
+    static const QString metadata = QStringLiteral("Metadata");
+    static const QString playbackStatus = QStringLiteral("PlaybackStatus");
+    static const QString rate = QStringLiteral("Rate");
+    static const QString position = QStringLiteral("Position");
+
+    auto it = properties.find(metadata);
+    if (it != properties.end()) {
         QVariantMap md;
-        v.value<QDBusArgument>() >> md;
+        it->value<QDBusArgument>() >> md;
         updateMetadata(md);
-    });
-}
-
-void Mpris::updateMetadata(const QVariantMap &md)
-{
-    m_trackTitle = QString();
-    m_trackLength = 0;
-    m_trackPosition = 0;
-    for (auto i = md.begin(); i != md.end(); ++i) {
-        if (i.key() == QStringLiteral("xesam:title")) {
-            m_trackTitle = i.value().toString();
-        } else if (i.key() == QStringLiteral("mpris:length")) {
-            m_trackLength = i.value().toLongLong() / 1000;
+    }
+    it = properties.find(rate);
+    if (it != properties.end()) {
+        // keep extrapolating from where we are now with the new rate
+        double r = it->toDouble();
+        if (r != m_rate) {
+            m_position = trackPosition();
+            m_positionTime.restart();
+            m_rate = r;
+            emit rateChanged();
         }
     }
-    emit trackTitleChanged();
-    emit trackLengthChanged();
+    it = properties.find(playbackStatus);
+    if (it != properties.end()) {
+        updatePlaybackStatus(it->toString());
+    }
+    it = properties.find(position);
+    if (it != properties.end()) {
+        setPosition(it->toLongLong() / 1000);
+    }
 }
 
-void Mpris::getPlaybackStatus()
+void MprisPlayer::updateMetadata(const QVariantMap &md)
 {
-    getProperty(QStringLiteral("PlaybackStatus"), [this](const QVariant &v) {
-        updatePlaybackStatus(v.toString());
-    });
+    QString title = md.value(QStringLiteral("xesam:title")).toString();
+    quint32 length = md.value(QStringLiteral("mpris:length")).toLongLong() / 1000;
+
+    if (title != m_trackTitle) {
+        m_trackTitle = title;
+        emit trackTitleChanged();
+    }
+    if (length != m_trackLength) {
+        m_trackLength = length;
+        emit trackLengthChanged();
+    }
+    if (m_ready) {
+        getPosition();
+    }
 }
 
-void Mpris::updatePlaybackStatus(const QString &st)
+void MprisPlayer::updatePlaybackStatus(const QString &st)
 {
-    PlaybackStatus old = m_playbackStatus;
-
-    m_posTimer.stop();
+    Mpris::PlaybackStatus status;
     if (st == QStringLiteral("Playing")) {
-        m_playbackStatus = PlaybackStatus::Playing;
-        m_posTimer.start();
+        status = Mpris::PlaybackStatus::Playing;
     } else if (st == QStringLiteral("Paused")) {
-        if (m_playbackStatus == PlaybackStatus::Playing) {
-            m_trackPosition += m_posTimer.remainingTime();
-            emit trackPositionChanged();
-        }
-        m_playbackStatus = PlaybackStatus::Paused;
+        status = Mpris::PlaybackStatus::Paused;
     } else {
-        m_playbackStatus = PlaybackStatus::Stopped;
-        m_trackPosition = 0;
-        emit trackPositionChanged();
+        status = Mpris::PlaybackStatus::Stopped;
+    }
+    if (status == m_playbackStatus) {
+        return;
     }
-    if (m_playbackStatus != old) {
-        emit playbackStatusChanged();
+
+    // freeze the extrapolated position, and resync it with the player's
+    m_position = status == Mpris::PlaybackStatus::Stopped ? 0 : trackPosition();
+    m_positionTime.restart();
+    m_playbackStatus = status;
+    m_lastActivity = MprisPlayers::instance()->now();
+    emit playbackStatusChanged();
+    emit trackPositionChanged();
+    if (m_ready && status != Mpris::PlaybackStatus::Stopped) {
+        getPosition();
     }
 }
 
-void Mpris::getRate()
+void MprisPlayer::setPosition(qint64 ms)
 {
-    getProperty(QStringLiteral("Rate"), [this](const QVariant &v) {
-        updateRate(v.toDouble());
-    });
+    m_position = ms;
+    m_positionTime.restart();
+    emit trackPositionChanged();
 }
 
-void Mpris::updateRate(double rate)
+quint32 MprisPlayer::trackPosition() const
 {
-    m_rate = rate;
-    emit rateChanged();
+    qint64 pos = m_position;
+    if (m_playbackStatus == Mpris::PlaybackStatus::Playing) {
+        pos += m_positionTime.elapsed() * m_rate;
+    }
+
+    // https://github.com/clementine-player/Clementine/issues/5097
+    if (pos < 0 || pos > m_trackLength) {
+        return 0;
+    }
+    return pos;
 }
 
-void Mpris::getPosition()
+void MprisPlayer::propertiesChanged(const QString &, const QVariantMap &changed, const QStringList &invalidated)
 {
-    getProperty(QStringLiteral("Position"), [this](const QVariant &v) {
-        m_trackPosition = v.toDouble() / 1000;
-        emit trackPositionChanged();
-    });
+    update(changed);
+    if (!invalidated.isEmpty()) {
+        getAll();
+    }
 }
 
-void Mpris::updatePos()
+void MprisPlayer::seeked(qint64 time)
 {
-    m_trackPosition += m_posTimer.interval();
-    emit trackPositionChanged();
+    setPosition(time / 1000);
 }
 
-quint32 Mpris::trackPosition() const
+
+
+MprisPlayers::MprisPlayers()
+            : QObject()
 {
-    // https://github.com/clementine-player/Clementine/issues/5097
-    if (m_trackPosition > m_trackLength) {
-        return 0;
-    }
-    return m_trackPosition;
+    m_clock.start();
+
+    QDBusServiceWatcher *watcher = new QDBusServiceWatcher(MPRIS_SERVICE_PREFIX + QLatin1Char('*'), QDBusConnection::sessionBus(),
+                                                           QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(watcher, &QDBusServiceWatcher::serviceRegistered, this, &MprisPlayers::addService);
+    connect(watcher, &QDBusServiceWatcher::serviceUnregistered, this, &MprisPlayers::removeService);
+
+    DBusInterface iface(DBUS_SERVICE, QStringLiteral("/"), DBUS_SERVICE);
+    QDBusPendingCall call = iface.asyncCall(QStringLiteral("ListNames"));
+    QDBusPendingCallWatcher *callWatcher = new QDBusPendingCallWatcher(call, this);
+    connect(callWatcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        QDBusPendingReply<QStringList> reply = *watcher;
+
+        if (reply.isError()) {
+            qDebug("Failed to get the list of DBus services.");
+            return;
+        }
+        foreach (const QString &service, reply.value()) {
+            if (service.startsWith(MPRIS_SERVICE_PREFIX)) {
+                addService(service);
+            }
+        }
+    });
 }
 
-void Mpris::propertiesChanged(const QString &, const QMap<QString, QVariant> &changed, const QStringList &invalidated)
+MprisPlayers *MprisPlayers::instance()
 {
-    static const QString metadata = QStringLiteral("Metadata");
-    if (changed.contains(metadata)) {
-        QVariantMap md;
-        changed.value(metadata).value<QDBusArgument>() >> md;
-        updateMetadata(md);
-    } else if (invalidated.contains(metadata)) {
-        getMetadata();
-    }
-    static const QString playbackStatus = QStringLiteral("PlaybackStatus");
-    if (changed.contains(playbackStatus)) {
-        updatePlaybackStatus(changed.value(playbackStatus).toString());
-    } else if (invalidated.contains(playbackStatus)) {
-        getPlaybackStatus();
+    static MprisPlayers *players = new MprisPlayers;
+    return players;
+}
+
+void MprisPlayers::addService(const QString &service)
+{
+    if (m_players.contains(service)) {
+        return;
     }
+    m_players.insert(service, nullptr);
 
-    static const QString rate = QStringLiteral("Rate");
-    if (changed.contains(rate)) {
-        updateRate(changed.value(rate).toDouble());
-    } else if (invalidated.contains(rate)) {
-        getRate();
+    DBusInterface iface(DBUS_SERVICE, QStringLiteral("/"), DBUS_SERVICE);
+    QDBusPendingCall call = iface.asyncCall(QStringLiteral("GetConnectionUnixProcessID"), service);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        QDBusPendingReply<quint32> reply = *watcher;
+
+        // the service may have gone away in the meantime
+        auto it = m_players.find(service);
+        if (it == m_players.end()) {
+            return;
+        }
+        if (reply.isError()) {
+            qDebug("Unable to get the pid of service %s.", qPrintable(service));
+            m_players.erase(it);
+            return;
+        }
+
+        MprisPlayer *player = new MprisPlayer(service, reply.value(), this);
+        *it = player;
+        m_byPid.insert(player->pid(), player);
+        connect(player, &MprisPlayer::ready, this, &MprisPlayers::playersChanged);
+        connect(player, &MprisPlayer::playbackStatusChanged, this, &MprisPlayers::playersChanged);
+    });
+}
+
+void MprisPlayers::removeService(const QString &service)
+{
+    MprisPlayer *player = m_players.take(service);
+    if (player) {
+        m_byPid.remove(player->pid(), player);
+        delete player;
+        emit playersChanged();
     }
 }
 
-void Mpris::seeked(qint64 time)
+MprisPlayer *MprisPlayers::player(quint32 pid) const
 {
-    m_trackPosition = time / 1000;
-    emit trackPositionChanged();
+    MprisPlayer *best = nullptr;
+    for (auto it = m_byPid.find(pid); it != m_byPid.end() && it.key() == pid; ++it) {
+        MprisPlayer *p = *it;
+        if (!p->isReady()) {
+            continue;
+        }
+        if (!best) {
+            best = p;
+            continue;
+        }
+        bool playing = p->playbackStatus() == Mpris::PlaybackStatus::Playing;
+        bool bestPlaying = best->playbackStatus() == Mpris::PlaybackStatus::Playing;
+        if (playing != bestPlaying) {
+            if (playing) {
+                best = p;
+            }
+        } else if (p->lastActivity() > best->lastActivity()) {
+            best = p;
+        }
+    }
+    return best;
 }
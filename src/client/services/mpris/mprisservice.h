@@ -20,10 +20,10 @@
 #ifndef MPRISSERVICE_H
 #define MPRISSERVICE_H
 
-#include <functional>
-
 #include <QQmlExtensionPlugin>
-#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVariantMap>
 
 class MprisPlugin : public QQmlExtensionPlugin
 {
@@ -33,6 +33,8 @@ public:
     void registerTypes(const char *uri) override;
 };
 
+class MprisPlayer;
+
 class Mpris : public QObject
 {
     Q_PROPERTY(bool valid READ isValid NOTIFY validChanged)
@@ -41,6 +43,7 @@ class Mpris : public QObject
     Q_PROPERTY(QString trackTitle READ trackTitle NOTIFY trackTitleChanged)
     Q_PROPERTY(quint32 trackLength READ trackLength NOTIFY trackLengthChanged)
     Q_PROPERTY(quint32 trackPosition READ trackPosition NOTIFY trackPositionChanged)
+    Q_PROPERTY(double rate READ rate NOTIFY rateChanged)
     Q_OBJECT
 public:
     enum class PlaybackStatus {
@@ -56,10 +59,16 @@ public:
     bool isValid() const;
     quint64 pid() const;
     void setPid(quint64 pid);
-    inline PlaybackStatus playbackStatus() const { return m_playbackStatus; }
-    inline QString trackTitle() const { return m_trackTitle; }
-    inline quint32 trackLength() const { return m_trackLength; }
+    PlaybackStatus playbackStatus() const;
+    QString trackTitle() const;
+    quint32 trackLength() const;
+    /**
+     * The position is extrapolated from the last one the player sent us, so it
+     * is up to date whenever it is read. trackPositionChanged() is only emitted
+     * when the position jumps, e.g. on seeks or when the track changes.
+     */
     quint32 trackPosition() const;
+    double rate() const;
 
 public slots:
     void playPause();
@@ -76,34 +85,93 @@ signals:
     void trackPositionChanged();
     void rateChanged();
 
+private:
+    void selectPlayer();
+    void call(const char *method);
+
+    bool m_valid;
+    quint64 m_pid;
+    QPointer<MprisPlayer> m_player;
+};
+
+/*
+ * A MPRIS player on the bus. All the players are tracked together by MprisPlayers,
+ * and the Mpris objects pick the one for their pid.
+ */
+class MprisPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    MprisPlayer(const QString &service, quint32 pid, QObject *parent);
+
+    QString service() const { return m_service; }
+    quint32 pid() const { return m_pid; }
+    bool isReady() const { return m_ready; }
+    Mpris::PlaybackStatus playbackStatus() const { return m_playbackStatus; }
+    QString trackTitle() const { return m_trackTitle; }
+    quint32 trackLength() const { return m_trackLength; }
+    quint32 trackPosition() const;
+    double rate() const { return m_rate; }
+    qint64 lastActivity() const { return m_lastActivity; }
+
+signals:
+    void ready();
+    void playbackStatusChanged();
+    void trackTitleChanged();
+    void trackLengthChanged();
+    void trackPositionChanged();
+    void rateChanged();
+
 private slots:
-    void propertiesChanged(const QString &service, const QMap<QString, QVariant> &, const QStringList &);
+    void propertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
     void seeked(qint64 time);
 
 private:
-    void checkConnection();
-    void checkServices(const QStringList &services);
-    void checkService(const QString &service);
-    void setValid(bool v);
-    void getProperty(const QString &property, const std::function<void (const QVariant &v)> &func);
-    void getMetadata();
+    void getAll();
+    void getPosition();
+    void update(const QVariantMap &properties);
     void updateMetadata(const QVariantMap &md);
-    void getPlaybackStatus();
     void updatePlaybackStatus(const QString &st);
-    void getRate();
-    void updateRate(double rate);
-    void getPosition();
-    void updatePos();
+    void setPosition(qint64 ms);
 
-    bool m_valid;
-    quint64 m_pid;
     QString m_service;
-    PlaybackStatus m_playbackStatus;
+    quint32 m_pid;
+    bool m_ready;
+    Mpris::PlaybackStatus m_playbackStatus;
     QString m_trackTitle;
     quint32 m_trackLength;
-    quint32 m_trackPosition;
+    // the position at the time m_positionTime was started
+    qint64 m_position;
+    QElapsedTimer m_positionTime;
     double m_rate;
-    QTimer m_posTimer;
+    qint64 m_lastActivity;
+};
+
+class MprisPlayers : public QObject
+{
+    Q_OBJECT
+public:
+    static MprisPlayers *instance();
+
+    /**
+     * Returns the active player of the process, preferring the one that is playing
+     * and then the one that changed state last.
+     */
+    MprisPlayer *player(quint32 pid) const;
+    qint64 now() const { return m_clock.elapsed(); }
+
+signals:
+    void playersChanged();
+
+private:
+    MprisPlayers();
+
+    void addService(const QString &service);
+    void removeService(const QString &service);
+
+    QHash<QString, MprisPlayer *> m_players;
+    QMultiHash<quint32, MprisPlayer *> m_byPid;
+    QElapsedTimer m_clock;
 };
 
 #endif
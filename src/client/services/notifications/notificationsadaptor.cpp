@@ -100,24 +100,15 @@ inline bool hasHint(const QVariantMap &hints, QString &hint)
 uint NotificationsAdaptor::Notify(const QString &app_name, uint id, const QString &icon, const QString &summary, const QString &body, const QStringList &actions, const QVariantMap &hints, int timeout)
 {
     // handle method call org.freedesktop.Notifications.Notify
-    static uint return_id = 0;
-
-    Notification *notification = new Notification;
-    notification->setId(++return_id);
-    notification->setBody(body);
-    notification->setSummary(summary);
-    notification->setIconName(icon);
-
+    QPixmap pixmap;
     QString hint;
     if (hasHint(hints, hint, QStringLiteral("image-data"), QStringLiteral("image_data"))) {
         DBusImageStruct img;
         hints.value(hint).value<QDBusArgument>() >> img;
         QImage::Format format = img.hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888;
         QImage image((const uchar *)img.data.constData(),img.width, img.height, img.rowstride, format);
-        notification->setIconImage(QPixmap::fromImage(image));
+        pixmap = QPixmap::fromImage(image);
     }
 
-    m_service->newNotification(notification);
-    return return_id;
+    return m_service->addNotification(app_name, id, icon, summary, body, pixmap, timeout);
 }
-
@@ -17,20 +17,20 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QIcon>
 #include <QDebug>
 #include <QPixmap>
 
 #include "notificationsiconprovider.h"
 #include "notificationsservice.h"
+#include "iconcache.h"
 
 NotificationsIconProvider::NotificationsIconProvider(NotificationsManager *service)
-                         : QQuickImageProvider(QQuickImageProvider::Pixmap)
+                         : QQuickImageProvider(QQuickImageProvider::Image)
                          , m_service(service)
 {
 }
 
-QPixmap NotificationsIconProvider::requestPixmap(const QString &id, QSize *realSize, const QSize &requestedSize)
+QImage NotificationsIconProvider::requestImage(const QString &id, QSize *realSize, const QSize &requestedSize)
 {
     QSize size(requestedSize);
     if (size.width() < 1) size.setWidth(1);
@@ -38,23 +38,27 @@ QPixmap NotificationsIconProvider::requestPixmap(const QString &id, QSize *realS
 
     *realSize = size;
 
-    int i = id.toInt();
+    // the id is "notification id/revision"
+    int i = id.section(QLatin1Char('/'), 0, 0).toInt();
     Notification *notification = m_service->notification(i);
+    if (!notification) {
+        return IconCache::icon(QStringLiteral("dialog-information"), size);
+    }
 
     QPixmap image = notification->iconImage();
     if (!image.isNull()) {
         *realSize = image.size();
-        return image;
+        return image.toImage();
     }
 
     QString iconName = notification->iconName();
     if (!iconName.isEmpty()) {
-        QIcon icon = QIcon::fromTheme(iconName);
+        QImage icon = IconCache::icon(iconName, size);
         if (!icon.isNull()) {
-            return icon.pixmap(size);
+            return icon;
         }
         qDebug("Cannot find the requested notification icon: \"%s\".", qPrintable(iconName));
     }
 
-    return QIcon::fromTheme(QStringLiteral("dialog-information")).pixmap(size);
+    return IconCache::icon(QStringLiteral("dialog-information"), size);
 }
@@ -24,12 +24,16 @@
 
 class NotificationsManager;
 
+/*
+ * The icons come from the Notifications, which live in the GUI thread, so the
+ * images must not be loaded with 'asynchronous: true'.
+ */
 class NotificationsIconProvider : public QQuickImageProvider
 {
 public:
     explicit NotificationsIconProvider(NotificationsManager *service);
 
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize);
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
 
 private:
     NotificationsManager *m_service;
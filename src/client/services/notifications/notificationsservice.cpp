@@ -35,20 +35,22 @@ void NotificationsPlugin::registerTypes(const char *uri)
 }
 
 
-Notification::Notification()
+Notification::Notification(int id, const QString &appName)
             : QObject()
+            , m_id(id)
+            , m_appName(appName)
+            , m_revision(0)
+            , m_timeout(0)
+            , m_shown(false)
 {
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &Notification::timedOut);
 }
 
-void Notification::timerEvent(QTimerEvent *e)
+QString Notification::iconSource() const
 {
-    emit expired();
-    deleteLater();
-}
-
-void Notification::setId(int id)
-{
-    m_id = id;
+    // the revision makes the image provider be asked again when the icon changes
+    return QStringLiteral("image://notifications/%1/%2").arg(m_id).arg(m_revision);
 }
 
 void Notification::setSummary(const QString &s)
@@ -71,10 +73,42 @@ void Notification::setIconImage(const QPixmap &img)
     m_iconImage = img;
 }
 
+void Notification::setTimeout(int ms)
+{
+    m_timeout = ms;
+}
+
+void Notification::update()
+{
+    ++m_revision;
+    if (m_shown) {
+        show();
+    }
+    emit changed();
+}
+
+void Notification::show()
+{
+    m_shown = true;
+    m_timer.stop();
+    if (m_timeout > 0) {
+        m_timer.start(m_timeout);
+    }
+}
+
+void Notification::close()
+{
+    m_timer.stop();
+    emit expired();
+    deleteLater();
+}
+
 
 
 NotificationsManager::NotificationsManager(QObject *p)
                     : QObject(p)
+                    , m_lastId(0)
+                    , m_visible(0)
 {
     static const QString notificationsService = QStringLiteral("org.freedesktop.Notifications");
     QStringList caps = { QStringLiteral("actions"), QStringLiteral("action-icons"), QStringLiteral("body-markup") };
@@ -90,20 +124,152 @@ NotificationsManager::NotificationsManager(QObject *p)
     QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/freedesktop/Notifications"), this);
 
     Client::client()->qmlEngine()->addImageProvider(QStringLiteral("notifications"), new NotificationsIconProvider(this));
+
+    // notifications often come in bursts, show them all together once the burst is over
+    // so that they are laid out only once
+    m_showTimer.setSingleShot(true);
+    m_showTimer.setInterval(0);
+    connect(&m_showTimer, &QTimer::timeout, this, &NotificationsManager::showQueued);
+    m_clock.start();
 }
 
 NotificationsManager::~NotificationsManager()
 {
+    qDeleteAll(m_notifications);
+}
+
+uint NotificationsManager::addNotification(const QString &appName, uint replacesId, const QString &icon, const QString &summary,
+                                           const QString &body, const QPixmap &image, int timeout)
+{
+    if (timeout < 0) {
+        timeout = DefaultTimeout;
+    }
+
+    Notification *n = m_notifications.value(replacesId);
+    if (n && n->appName() == appName) {
+        n->setSummary(summary);
+        n->setBody(body);
+        n->setIconName(icon);
+        n->setIconImage(image);
+        n->setTimeout(timeout);
+        n->update();
+        return replacesId;
+    }
+
+    App &app = m_apps[appName];
+    pruneRecent(app);
+    if (app.recent.size() < MaxPerApp) {
+        app.recent << m_clock.elapsed();
+
+        n = createNotification(appName, timeout);
+        n->setSummary(summary);
+        n->setBody(body);
+        n->setIconName(icon);
+        n->setIconImage(image);
+        return n->id();
+    }
+
+    // the app is flooding us, fold the notification in the one for the app
+    uint id = ++m_lastId;
+    app.coalescedIds << id;
+    bool created = !app.coalesced;
+    if (created) {
+        app.coalesced = createNotification(appName, DefaultTimeout);
+    }
+    n = app.coalesced;
+    n->setSummary(tr("%n more from %1", nullptr, app.coalescedIds.size()).arg(appName));
+    n->setBody(summary);
+    n->setIconName(icon);
+    n->setIconImage(image);
+    if (!created) {
+        n->update();
+    }
+    return id;
+}
+
+void NotificationsManager::pruneRecent(App &app)
+{
+    qint64 now = m_clock.elapsed();
+    while (!app.recent.isEmpty() && now - app.recent.first() > RateWindow) {
+        app.recent.removeFirst();
+    }
+}
+
+Notification *NotificationsManager::createNotification(const QString &appName, int timeout)
+{
+    uint id = ++m_lastId;
+    Notification *n = new Notification(id, appName);
+    n->setTimeout(timeout);
+    connect(n, &Notification::timedOut, this, [this, id]() { close(id, Expired); });
+    m_notifications.insert(id, n);
 
+    if (m_queue.size() >= MaxQueued) {
+        close(m_queue.first()->id(), Expired);
+    }
+    m_queue << n;
+    m_showTimer.start();
+    return n;
 }
 
-void NotificationsManager::newNotification(Notification *n)
+void NotificationsManager::showQueued()
 {
-    int id = n->id();
-    m_notifications[id] = n;
-    n->startTimer(5000);
-    connect(n, &Notification::expired, [this, id]() { m_notifications.remove(id); });
-    emit notify(n);
+    for (auto it = m_queue.begin(); m_visible < MaxVisible && it != m_queue.end();) {
+        Notification *n = *it;
+        if (n->isPersistent()) {
+            if (m_persistent.size() >= MaxPersistent) {
+                ++it;
+                continue;
+            }
+            m_persistent.insert(n->id());
+        }
+        it = m_queue.erase(it);
+        ++m_visible;
+        n->show();
+        emit notify(n);
+    }
+}
+
+void NotificationsManager::CloseNotification(uint id)
+{
+    close(id, Closed);
+}
+
+void NotificationsManager::dismiss(uint id)
+{
+    close(id, Dismissed);
+}
+
+void NotificationsManager::close(uint id, CloseReason reason)
+{
+    Notification *n = m_notifications.take(id);
+    if (!n) {
+        return;
+    }
+
+    if (!m_queue.removeOne(n)) {
+        --m_visible;
+        m_persistent.remove(id);
+        m_showTimer.start();
+    }
+
+    auto it = m_apps.find(n->appName());
+    if (it != m_apps.end()) {
+        App &app = *it;
+        if (app.coalesced == n) {
+            for (uint id: app.coalescedIds) {
+                emit NotificationClosed(id, reason);
+            }
+            app.coalesced = nullptr;
+            app.coalescedIds.clear();
+        }
+        pruneRecent(app);
+        if (app.recent.isEmpty() && !app.coalesced) {
+            m_apps.erase(it);
+        }
+    }
+
+    emit NotificationClosed(id, reason);
+    n->close();
 }
 
 Notification *NotificationsManager::notification(int id) const
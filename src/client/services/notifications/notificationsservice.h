@@ -22,6 +22,9 @@
 
 #include <QDBusAbstractAdaptor>
 #include <QPixmap>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QSet>
 #include <QQmlExtensionPlugin>
 
 class NotificationsPlugin : public QQmlExtensionPlugin
@@ -36,54 +39,119 @@ class Notification : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(int id READ id CONSTANT)
-    Q_PROPERTY(QString summary READ summary CONSTANT)
-    Q_PROPERTY(QString body READ body CONSTANT)
+    Q_PROPERTY(QString appName READ appName CONSTANT)
+    Q_PROPERTY(QString summary READ summary NOTIFY changed)
+    Q_PROPERTY(QString body READ body NOTIFY changed)
+    Q_PROPERTY(QString iconSource READ iconSource NOTIFY changed)
 
 public:
-    Notification();
+    Notification(int id, const QString &appName);
 
     int id() const { return m_id; }
+    bool isPersistent() const { return m_timeout == 0; }
+    QString appName() const { return m_appName; }
     QString summary() const { return m_summary; }
     QString body() const { return m_body; }
     QString iconName() const { return m_iconName; }
     QPixmap iconImage() const { return m_iconImage; }
+    QString iconSource() const;
 
-    void setId(int id);
     void setSummary(const QString &s);
     void setBody(const QString &body);
     void setIconName(const QString &icon);
     void setIconImage(const QPixmap &img);
-
-protected:
-    void timerEvent(QTimerEvent *e);
+    /**
+     * Set the time after which the notification expires, once shown.
+     * A timeout of 0 means it never expires.
+     */
+    void setTimeout(int ms);
+
+    /**
+     * Notify the changes made with the setters, and restart the timeout if
+     * the notification is being shown.
+     */
+    void update();
+    void show();
+    void close();
 
 signals:
+    void changed();
     void expired();
+    void timedOut();
 
 private:
     int m_id;
+    QString m_appName;
     QString m_summary;
     QString m_body;
     QString m_iconName;
     QPixmap m_iconImage;
+    int m_revision;
+    int m_timeout;
+    bool m_shown;
+    QTimer m_timer;
 };
 
+/*
+ * Keeps the notifications, showing at most MaxVisible at a time and queueing the others.
+ * Only MaxPersistent of the visible ones can be notifications that never expire, so that
+ * they cannot take all the slots.
+ * Apps sending more than MaxPerApp notifications in RateWindow milliseconds get the
+ * ones in excess coalesced in a single notification, updated in place.
+ */
 class NotificationsManager : public QObject
 {
     Q_OBJECT
 public:
+    enum CloseReason {
+        Expired = 1,
+        Dismissed = 2,
+        Closed = 3,
+    };
+
+    static const int DefaultTimeout = 5000;
+    static const int MaxVisible = 5;
+    static const int MaxPersistent = 3;
+    static const int MaxQueued = 50;
+    static const int MaxPerApp = 3;
+    static const int RateWindow = 10000;
+
     NotificationsManager(QObject *p = nullptr);
     ~NotificationsManager();
 
-    void newNotification(Notification *notification);
+    uint addNotification(const QString &appName, uint replacesId, const QString &icon, const QString &summary,
+                         const QString &body, const QPixmap &image, int timeout);
 
     Notification *notification(int id) const;
+    Q_INVOKABLE void dismiss(uint id);
+
+public slots:
+    void CloseNotification(uint id);
 
 signals:
     void notify(Notification *notification);
+    void NotificationClosed(uint id, uint reason);
 
 private:
+    struct App {
+        QVector<qint64> recent;
+        Notification *coalesced = nullptr;
+        QVector<uint> coalescedIds;
+    };
+
+    void pruneRecent(App &app);
+    Notification *createNotification(const QString &appName, int timeout);
+    void close(uint id, CloseReason reason);
+    void showQueued();
+
+    uint m_lastId;
     QHash<int, Notification *> m_notifications;
+    QHash<QString, App> m_apps;
+    QList<Notification *> m_queue;
+    int m_visible;
+    QSet<uint> m_persistent;
+    QTimer m_showTimer;
+    QElapsedTimer m_clock;
 };
 
 #endif
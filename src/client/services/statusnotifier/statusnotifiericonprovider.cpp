@@ -17,45 +17,43 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QIcon>
 #include <QDebug>
 
 #include "statusnotifiericonprovider.h"
 #include "statusnotifieritem.h"
 #include "statusnotifierservice.h"
+#include "iconcache.h"
 
 StatusNotifierIconProvider::StatusNotifierIconProvider(StatusNotifierManager *service)
-                          : QQuickImageProvider(QQuickImageProvider::Pixmap)
+                          : QQuickImageProvider(QQuickImageProvider::Image)
                           , m_service(service)
 {
 }
 
-static QPixmap getPixmap(StatusNotifierItem *item, const QSize &s, const QStringRef &type)
+static QImage getImage(StatusNotifierItem *item, const QSize &s, const QStringRef &type)
 {
     if (type == QLatin1String("attentionIcon")) {
-        QPixmap pix = item->attentionIconPixmap(s);
-        if (pix.isNull()) {
+        QImage image = item->attentionIconImage(s);
+        if (image.isNull()) {
             QString name = item->attentionIconName();
             if (!name.isEmpty()) {
-                QIcon icon = QIcon::fromTheme(name);
-                pix = icon.pixmap(s);
+                image = IconCache::icon(name, s);
             }
         }
-        return pix;
+        return image;
     }
 
-    QPixmap pix = item->iconPixmap(s);
-    if (pix.isNull()) {
+    QImage image = item->iconImage(s);
+    if (image.isNull()) {
         QString name = item->iconName();
         if (!name.isEmpty()) {
-            QIcon icon = QIcon::fromTheme(name);
-            pix = icon.pixmap(s);
+            image = IconCache::icon(name, s);
         }
     }
-    return pix;
+    return image;
 }
 
-QPixmap StatusNotifierIconProvider::requestPixmap(const QString &id, QSize *realSize, const QSize &requestedSize)
+QImage StatusNotifierIconProvider::requestImage(const QString &id, QSize *realSize, const QSize &requestedSize)
 {
     QSize size(requestedSize);
     if (size.width() < 1) size.setWidth(1);
@@ -65,7 +63,7 @@ QPixmap StatusNotifierIconProvider::requestPixmap(const QString &id, QSize *real
 
 #define FAIL \
     qWarning("StatusNotifierIconProvider: cannot load icon \"%s\".", qPrintable(id)); \
-    return QIcon::fromTheme(QStringLiteral("image-missing")).pixmap(size);
+    return IconCache::icon(QStringLiteral("image-missing"), size);
 
     const auto &l = id.splitRef(QLatin1Char('/'));
     if (l.size() != 2) {
@@ -77,9 +75,9 @@ QPixmap StatusNotifierIconProvider::requestPixmap(const QString &id, QSize *real
 
     StatusNotifierItem *item = m_service->item(service);
     if (item) {
-        QPixmap pix = getPixmap(item, size, name);
-        if (!pix.isNull())
-            return pix;
+        QImage image = getImage(item, size, name);
+        if (!image.isNull())
+            return image;
     }
 
     FAIL
@@ -24,12 +24,16 @@
 
 class StatusNotifierManager;
 
+/*
+ * The icons come from the StatusNotifierItems, which live in the GUI thread, so
+ * the images must not be loaded with 'asynchronous: true'.
+ */
 class StatusNotifierIconProvider : public QQuickImageProvider
 {
 public:
     StatusNotifierIconProvider(StatusNotifierManager *service);
 
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize);
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
 
 private:
     StatusNotifierManager *m_service;
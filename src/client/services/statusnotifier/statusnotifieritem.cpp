@@ -25,6 +25,7 @@
 #include <QDBusServiceWatcher>
 #include <QDBusMetaType>
 #include <QPoint>
+#include <QtEndian>
 #include <QDebug>
 
 #include "statusnotifieritem.h"
@@ -105,8 +106,8 @@ StatusNotifierItem::StatusNotifierItem(const QString &service, QObject *p)
     bus.connect(service, PATH, INTERFACE, QStringLiteral("NewToolTip"), this, SLOT(getTooltip()));
     bus.connect(service, PATH, INTERFACE, QStringLiteral("NewStatus"), this, SLOT(getStatus()));
 
-    m_icon.updatePending = 0;
-    m_attentionIcon.updatePending = 0;
+    initIcon(m_icon, &StatusNotifierItem::iconChanged);
+    initIcon(m_attentionIcon, &StatusNotifierItem::attentionIconChanged);
 
     getProperty(m_service, QStringLiteral("Id"), [this](const QVariant &v) {
         m_name = v.toString();
@@ -143,11 +144,58 @@ QString StatusNotifierItem::iconName() const
     return m_icon.name;
 }
 
-static QPixmap pixmap(const QSize &s, const DBusImageVector &vec)
+void StatusNotifierItem::initIcon(Icon &icon, void (StatusNotifierItem::*changed)())
 {
+    icon.updatePending = 0;
+    icon.hash = 0;
+    icon.signalPending = false;
+    icon.signalTimer.setSingleShot(true);
+    icon.signalTimer.setInterval(MinIconInterval);
+    connect(&icon.signalTimer, &QTimer::timeout, this, [this, &icon, changed]() {
+        if (icon.signalPending) {
+            icon.signalPending = false;
+            icon.signalTimer.start();
+            emit (this->*changed)();
+        }
+    });
+}
+
+void StatusNotifierItem::iconUpdated(Icon &icon, void (StatusNotifierItem::*changed)())
+{
+    // many apps send the new icon signal even if the icon didn't change, or they
+    // send the same few frames over and over
+    uint hash = qHash(icon.name);
+    foreach (const DBusImageStruct &img, icon.pixmap) {
+        hash = qHash(img.data, hash ^ (img.width << 16 | img.height));
+    }
+    if (hash == icon.hash && icon.name == icon.shownName && icon.pixmap == icon.shownPixmap) {
+        return;
+    }
+    icon.hash = hash;
+    // the vectors and the byte arrays are shared, this doesn't copy the pixels
+    icon.shownName = icon.name;
+    icon.shownPixmap = icon.pixmap;
+    icon.images.clear();
+
+    if (icon.signalTimer.isActive()) {
+        icon.signalPending = true;
+        return;
+    }
+    icon.signalTimer.start();
+    emit (this->*changed)();
+}
+
+QImage StatusNotifierItem::image(const QSize &s, Icon &icon)
+{
+    auto key = qMakePair(s.width(), s.height());
+    auto it = icon.images.constFind(key);
+    if (it != icon.images.constEnd()) {
+        return *it;
+    }
+
     const DBusImageStruct *image = nullptr;
     int dw, dh;
-    foreach (const DBusImageStruct &img, vec) {
+    foreach (const DBusImageStruct &img, icon.pixmap) {
         int _dw = qAbs(img.width - s.width());
         int _dh = qAbs(img.height - s.height());
         if (!image || _dw < dw || _dh < dh) {
@@ -156,16 +204,26 @@ static QPixmap pixmap(const QSize &s, const DBusImageVector &vec)
             dh = _dh;
         }
     }
-    if (image) {
-        QImage img((const uchar *)image->data.constData(), image->width, image->height, QImage::Format_ARGB32);
-        return QPixmap::fromImage(img);
+
+    QImage result;
+    if (image && image->width > 0 && image->height > 0 && image->data.size() >= image->width * image->height * 4) {
+        // the pixels are ARGB32 in network byte order
+        result = QImage(image->width, image->height, QImage::Format_ARGB32);
+        const quint32 *src = reinterpret_cast<const quint32 *>(image->data.constData());
+        for (int y = 0; y < image->height; ++y) {
+            quint32 *dst = reinterpret_cast<quint32 *>(result.scanLine(y));
+            for (int x = 0; x < image->width; ++x) {
+                dst[x] = qFromBigEndian(*src++);
+            }
+        }
     }
-    return QPixmap();
+    icon.images.insert(key, result);
+    return result;
 }
 
-QPixmap StatusNotifierItem::iconPixmap(const QSize &s) const
+QImage StatusNotifierItem::iconImage(const QSize &s) const
 {
-    return pixmap(s, m_icon.pixmap);
+    return image(s, m_icon);
 }
 
 QString StatusNotifierItem::attentionIconName() const
@@ -173,9 +231,9 @@ QString StatusNotifierItem::attentionIconName() const
     return m_attentionIcon.name;
 }
 
-QPixmap StatusNotifierItem::attentionIconPixmap(const QSize &s) const
+QImage StatusNotifierItem::attentionIconImage(const QSize &s) const
 {
-    return pixmap(s, m_attentionIcon.pixmap);
+    return image(s, m_attentionIcon);
 }
 
 QString StatusNotifierItem::tooltipTitle() const
@@ -221,7 +279,7 @@ void StatusNotifierItem::getIcon()
 {
     auto decreaseUpdatePending = [this]() {
         if (--m_icon.updatePending == 0)
-            emit iconChanged();
+            iconUpdated(m_icon, &StatusNotifierItem::iconChanged);
     };
 
     m_icon.updatePending += 2;
@@ -239,19 +297,17 @@ void StatusNotifierItem::getAttentionIcon()
 {
     auto decreaseUpdatePending = [this]() {
         if (--m_attentionIcon.updatePending == 0)
-            emit attentionIconChanged();
+            iconUpdated(m_attentionIcon, &StatusNotifierItem::attentionIconChanged);
     };
 
     m_attentionIcon.updatePending += 2;
     getProperty(m_service, QStringLiteral("AttentionIconName"), [=](const QVariant &v) {
         m_attentionIcon.name = v.toString();
-        if (--m_attentionIcon.updatePending)
-            emit attentionIconChanged();
+        decreaseUpdatePending();
     }, decreaseUpdatePending);
     getProperty(m_service, QStringLiteral("AttentionIconPixmap"), [=](const QVariant &v) {
         v.value<QDBusArgument>() >> m_attentionIcon.pixmap;
-        if (--m_attentionIcon.updatePending)
-            emit attentionIconChanged();
+        decreaseUpdatePending();
     }, decreaseUpdatePending);
 }
 
@@ -22,7 +22,9 @@
 
 #include <QObject>
 #include <QVector>
-#include <QPixmap>
+#include <QImage>
+#include <QHash>
+#include <QTimer>
 
 #include "dbusinterface.h"
 
@@ -33,6 +35,11 @@ struct DBusImageStruct {
     QByteArray data;
 };
 
+inline bool operator==(const DBusImageStruct &a, const DBusImageStruct &b)
+{
+    return a.width == b.width && a.height == b.height && a.data == b.data;
+}
+
 typedef QVector<DBusImageStruct> DBusImageVector;
 
 struct DBusToolTipStruct {
@@ -65,9 +72,9 @@ public:
     QString name() const;
     QString title() const;
     QString iconName() const;
-    QPixmap iconPixmap(const QSize &size) const;
+    QImage iconImage(const QSize &size) const;
     QString attentionIconName() const;
-    QPixmap attentionIconPixmap(const QSize &size) const;
+    QImage attentionIconImage(const QSize &size) const;
     QString tooltipTitle() const;
     Status status() const;
 
@@ -91,16 +98,32 @@ private slots:
     void getTooltip();
     void getStatus();
 private:
+    // apps animating their icon may change it very often, don't reload it more than this
+    static const int MinIconInterval = 200;
+
     struct Icon {
         QString name;
         DBusImageVector pixmap;
         int updatePending;
+        // the icon last signaled, the hash is only a quick check before comparing the data
+        uint hash;
+        QString shownName;
+        DBusImageVector shownPixmap;
+        // the images converted from the pixmaps, by requested size
+        QHash<QPair<int, int>, QImage> images;
+        QTimer signalTimer;
+        bool signalPending;
     };
+    void initIcon(Icon &icon, void (StatusNotifierItem::*changed)());
+    void iconUpdated(Icon &icon, void (StatusNotifierItem::*changed)());
+    static QImage image(const QSize &size, Icon &icon);
+
+
     QString m_service;
     QString m_name;
     QString m_title;
-    Icon m_icon;
-    Icon m_attentionIcon;
+    mutable Icon m_icon;
+    mutable Icon m_attentionIcon;
     DBusToolTipStruct m_tooltip;
     Status m_status;
     DBusInterface m_interface;
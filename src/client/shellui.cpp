@@ -35,6 +35,8 @@
 #include <QProcess>
 #include <QFileInfo>
 #include <QDir>
+#include <QSaveFile>
+#include <QRunnable>
 
 #include "client.h"
 #include "element.h"
@@ -127,6 +129,7 @@ ShellUI::ShellUI(Client *client, QQmlEngine *engine, const QString &configFile)
        : QObject(client)
        , m_client(client)
        , m_configFile(configFile)
+       , m_shellDirty(false)
        , m_configMode(false)
        , m_cursorShape(-1)
        , m_engine(engine)
@@ -135,6 +138,14 @@ ShellUI::ShellUI(Client *client, QQmlEngine *engine, const QString &configFile)
 {
     m_engine->rootContext()->setContextProperty(QStringLiteral("Ui"), this);
 
+    // settings are often changed many times in a row, e.g. while dragging a slider,
+    // wait for things to settle down before writing them out
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(1000);
+    connect(&m_saveTimer, &QTimer::timeout, this, &ShellUI::writeConfig);
+    // one thread, so that the writes happen in order
+    m_savePool.setMaxThreadCount(1);
+
     client->addWorkspace(0);
     reloadConfigFile();
     reloadConfig();
@@ -142,6 +153,10 @@ ShellUI::ShellUI(Client *client, QQmlEngine *engine, const QString &configFile)
 
 ShellUI::~ShellUI()
 {
+    if (m_saveTimer.isActive()) {
+        writeConfig();
+    }
+    m_savePool.waitForDone();
     qDeleteAll(m_screens);
 }
 
@@ -153,7 +168,14 @@ UiScreen *ShellUI::loadScreen(QScreen *sc, const QString &name)
     loadScreen(screen);
 
     m_screens << screen;
-    connect(sc, &QObject::destroyed, [this, screen](QObject *) { delete screen; m_screens.removeOne(screen); });
+    connect(sc, &QObject::destroyed, [this, screen](QObject *) {
+        // keep the changes not saved yet, the save timer is still running
+        if (m_dirtyScreens.remove(screen)) {
+            storeScreenConfig(screen);
+        }
+        delete screen;
+        m_screens.removeOne(screen);
+    });
     return screen;
 }
 
@@ -284,11 +306,32 @@ void ShellUI::reloadConfig()
     }
 }
 
+static QString cacheFile(const QString &configFile)
+{
+    return configFile + QStringLiteral(".cache");
+}
+
 void ShellUI::reloadConfigFile()
 {
     m_rootConfig = QJsonObject();
     m_config = QJsonObject();
 
+    // the binary cache is written after the config file, if it is older someone
+    // edited the config by hand
+    QFileInfo configInfo(m_configFile);
+    QFileInfo cacheInfo(cacheFile(m_configFile));
+    if (configInfo.exists() && cacheInfo.exists() && cacheInfo.lastModified() >= configInfo.lastModified()) {
+        QFile cache(cacheInfo.filePath());
+        if (cache.open(QIODevice::ReadOnly)) {
+            QJsonDocument document = QJsonDocument::fromBinaryData(cache.readAll());
+            if (document.isObject()) {
+                m_rootConfig = document.object();
+                m_config = m_rootConfig[QStringLiteral("Ui")].toObject();
+                return;
+            }
+        }
+    }
+
     QFile file(m_configFile);
     if (file.open(QIODevice::ReadOnly)) {
         QJsonParseError error;
@@ -305,60 +348,114 @@ void ShellUI::reloadConfigFile()
 
 void ShellUI::saveConfig()
 {
-    QJsonObject object = m_config[QStringLiteral("Shell")].toObject();
-    QJsonObject properties = object[QStringLiteral("properties")].toObject();
-    foreach (const QString &prop, m_properties) {
-        QVariant value = property(qPrintable(prop));
-        bool ok;
-        int v = value.toInt(&ok);
-        if (ok) {
-            properties[prop] = v;
-        } else {
-            properties[prop] = value.toString();
-        }
+    m_shellDirty = true;
+    for (UiScreen *screen: m_screens) {
+        m_dirtyScreens.insert(screen);
     }
-    object[QStringLiteral("properties")] = properties;
+    m_saveTimer.start();
+}
 
-    QJsonObject screens = m_config[QStringLiteral("Screens")].toObject();
-    foreach (UiScreen *screen, m_screens) {
-        QJsonObject screenConfig = screens[screen->name()].toObject();
-        screen->saveConfig(screenConfig);
-        screens[screen->name()] = screenConfig;
+void ShellUI::screenConfigChanged(UiScreen *screen)
+{
+    if (!screen) {
+        return;
     }
+    m_dirtyScreens.insert(screen);
+    m_saveTimer.start();
+}
+
+void ShellUI::storeScreenConfig(UiScreen *screen)
+{
+    QJsonObject screens = m_config[QStringLiteral("Screens")].toObject();
+    QJsonObject screenConfig = screens[screen->name()].toObject();
+    screen->saveConfig(screenConfig);
+    screens[screen->name()] = screenConfig;
     m_config[QStringLiteral("Screens")] = screens;
+}
+
+void ShellUI::writeConfig()
+{
+    m_saveTimer.stop();
+
+    if (m_shellDirty) {
+        QJsonObject object = m_config[QStringLiteral("Shell")].toObject();
+        QJsonObject properties = object[QStringLiteral("properties")].toObject();
+        foreach (const QString &prop, m_properties) {
+            QVariant value = property(qPrintable(prop));
+            bool ok;
+            int v = value.toInt(&ok);
+            if (ok) {
+                properties[prop] = v;
+            } else {
+                properties[prop] = value.toString();
+            }
+        }
+        object[QStringLiteral("properties")] = properties;
+        m_config[QStringLiteral("Shell")] = object;
+        m_shellDirty = false;
+    }
+
+    foreach (UiScreen *screen, m_dirtyScreens) {
+        storeScreenConfig(screen);
+    }
+    m_dirtyScreens.clear();
 
-    m_config[QStringLiteral("Shell")] = object;
     m_rootConfig[QStringLiteral("Ui")] = m_config;
 
-    QJsonDocument document(m_rootConfig);
+    // the json objects are implicitly shared, so this is just a cheap copy and the
+    // serialization and the writing can happen in another thread
+    class SaveTask : public QRunnable
+    {
+    public:
+        SaveTask(const QString &f, const QJsonObject &c) : configFile(f), config(c) {}
+        void run() override
+        {
+            QFileInfo info(configFile);
+            QDir dir(info.absoluteDir());
+            if (!dir.exists() && !dir.mkpath(dir.path())) {
+                qWarning("Failed to create the config directory '%s', cannot save the config.", qPrintable(dir.path()));
+                return;
+            }
 
-    QFile file(m_configFile);
-    QFileInfo info(file);
-    QDir dir(info.absoluteDir());
-    if (!dir.exists() && !dir.mkpath(dir.path())) {
-        qWarning("Failed to create the config directory '%s', cannot save the config.", qPrintable(dir.path()));
-        return;
-    }
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning("Failed to open %s for writing.", qPrintable(m_configFile));
-        return;
-    }
+            QByteArray data = QJsonDocument(config).toJson();
+            QByteArray filtered;
+            filtered.reserve(data.size());
+            int pos = 0;
+            while (pos < data.size()) {
+                int index = data.indexOf('\n', pos);
+                if (index < 0) {
+                    index = data.size() - 1;
+                }
+                QByteArray line = data.mid(pos, index - pos + 1);
+                pos = index + 1;
 
-    QByteArray data = document.toJson();
-    int pos = 0;
-    while (pos < data.size()) {
-        int index = data.indexOf('\n', pos);
-        QByteArray line = data.mid(pos, index - pos + 1);
-        pos = index + 1;
+                //filter out the ids from the saved config
+                if (line.contains("\"id\":")) {
+                    continue;
+                }
+                filtered += line;
+            }
 
-        //filter out the ids from the saved config
-        if (line.contains("\"id\":")) {
-            continue;
+            // write to a temporary file and rename it, so that we never leave a truncated config behind
+            QSaveFile file(configFile);
+            if (!file.open(QIODevice::WriteOnly) || file.write(filtered) != filtered.size() || !file.commit()) {
+                qWarning("Failed to write %s: %s", qPrintable(configFile), qPrintable(file.errorString()));
+                return;
+            }
+
+            QSaveFile cache(cacheFile(configFile));
+            if (cache.open(QIODevice::WriteOnly)) {
+                cache.write(QJsonDocument::fromJson(filtered).toBinaryData());
+                cache.commit();
+            }
+
+            qDebug("Saved Orbital config to %s.", qPrintable(configFile));
         }
-        file.write(line);
-    }
 
-    qDebug("Saved Orbital config to %s.", qPrintable(m_configFile));
+        QString configFile;
+        QJsonObject config;
+    };
+    m_savePool.start(new SaveTask(m_configFile, m_rootConfig));
 }
 
 void ShellUI::loadScreen(UiScreen *screen)
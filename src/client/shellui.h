@@ -24,6 +24,9 @@
 #include <QStringList>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QTimer>
+#include <QSet>
+#include <QThreadPool>
 
 class QQuickItem;
 class QQmlEngine;
@@ -72,6 +75,7 @@ public:
     Q_INVOKABLE void toggleConfigMode();
 
     UiScreen *findScreen(wl_output *output) const;
+    void screenConfigChanged(UiScreen *screen);
 
 public slots:
     void reloadConfig();
@@ -83,6 +87,8 @@ signals:
 private:
     void loadScreen(UiScreen *s);
     void reloadConfigFile();
+    void writeConfig();
+    void storeScreenConfig(UiScreen *screen);
     bool parseBinding(const QJsonObject &conf);
 
     Client *m_client;
@@ -90,6 +96,10 @@ private:
     QJsonObject m_rootConfig;
     QJsonObject m_config;
     QByteArray m_configData;
+    bool m_shellDirty;
+    QSet<UiScreen *> m_dirtyScreens;
+    QTimer m_saveTimer;
+    QThreadPool m_savePool;
     bool m_configMode;
     int m_cursorShape;
     QQmlEngine *m_engine;
@@ -25,6 +25,7 @@
 #include <QJsonObject>
 
 #include "style.h"
+#include "manifestindex.h"
 
 QMap<QString, StyleInfo *> Style::s_styles;
 
@@ -75,19 +76,14 @@ Style *Style::loadStyle(const QString &name, QQmlEngine *engine)
 
 void Style::loadStylesList()
 {
+    ManifestIndex index(QStringLiteral("styles"), QStringLiteral("style"));
     const QStringList dirs = QStandardPaths::standardLocations(QStandardPaths::DataLocation);
     for (const QString &path: dirs) {
-        QDir dir(QUrl(QStringLiteral("%1/../orbital/styles").arg(path)).toString(QUrl::NormalizePathSegments));
-        const QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-        for (const QString &subdir: subdirs) {
-            dir.cd(subdir);
-            if (dir.exists(QStringLiteral("style"))) {
-                if (!s_styles.contains(subdir)) {
-                    loadStyleInfo(subdir, dir.absolutePath());
-                }
+        index.scan(QStringLiteral("%1/../orbital/styles").arg(path), [](const QString &name, const QString &stylePath, const QJsonObject &json) {
+            if (!s_styles.contains(name)) {
+                loadStyleInfo(name, stylePath, json);
             }
-            dir.cdUp();
-        }
+        });
     }
 }
 
@@ -98,32 +94,13 @@ void Style::cleanupStylesList()
     }
 }
 
-void Style::loadStyleInfo(const QString &name, const QString &path)
+void Style::loadStyleInfo(const QString &name, const QString &path, const QJsonObject &json)
 {
-    QString filePath(path + QLatin1String("/style"));
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << QStringLiteral("Failed to load the style '%1'. Could not open %1 for reading.").arg(filePath);
-        return;
-    }
-
     StyleInfo *info = new StyleInfo;
     info->m_name = name;
     info->m_path = path;
     info->m_prettyName = name;
 
-    QByteArray data = file.readAll();
-    file.close();
-
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError) {
-        qWarning("Error parsing %s at offset %d: %s", qPrintable(filePath), error.offset, qPrintable(error.errorString()));
-        delete info;
-        return;
-    }
-    QJsonObject json = doc.object();
-
     if (json.contains(QStringLiteral("prettyName"))) {
         info->m_prettyName = json.value(QStringLiteral("prettyName")).toString();
     }
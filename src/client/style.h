@@ -26,6 +26,7 @@
 
 class QQmlComponent;
 class QQmlEngine;
+class QJsonObject;
 
 class StyleInfo : public QObject
 {
@@ -113,7 +114,7 @@ signals:
     void highlightColorChanged();
 
 private:
-    static void loadStyleInfo(const QString &name, const QString &path);
+    static void loadStyleInfo(const QString &name, const QString &path, const QJsonObject &json);
 
     static QMap<QString, StyleInfo *> s_styles;
 };
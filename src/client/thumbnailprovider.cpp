@@ -0,0 +1,169 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFileInfo>
+#include <QDir>
+#include <QUrl>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QThread>
+#include <QDebug>
+
+#include "thumbnailprovider.h"
+
+// the two sizes of the thumbnail spec, the large one is used for requests bigger than the normal one
+static const int NormalSize = 128;
+static const int LargeSize = 256;
+
+// owned by the pool, it only talks to the response through a connection, which
+// goes away if QML deletes the response first
+class ThumbnailTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    ThumbnailTask(const QString &path, const QSize &requestedSize, const QSharedPointer<QAtomicInt> &cancelled)
+        : m_path(path)
+        , m_requestedSize(requestedSize)
+        , m_cancelled(cancelled)
+    {
+    }
+
+    void run() override
+    {
+        emit done(m_cancelled->load() ? QImage() : thumbnail());
+    }
+
+signals:
+    void done(const QImage &image);
+
+private:
+    QImage thumbnail()
+    {
+        QFileInfo info(m_path);
+        if (!info.isFile()) {
+            return QImage();
+        }
+
+        int size = qMax(m_requestedSize.width(), m_requestedSize.height()) > NormalSize ? LargeSize : NormalSize;
+        QString uri = QString::fromUtf8(QUrl::fromLocalFile(info.absoluteFilePath()).toEncoded());
+        QString mtime = QString::number(info.lastModified().toTime_t());
+        QString hash = QString::fromLatin1(QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5).toHex());
+        QString file = QStringLiteral("%1/thumbnails/%2/%3.png").arg(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation),
+                                                                    size == LargeSize ? QStringLiteral("large") : QStringLiteral("normal"),
+                                                                    hash);
+
+        // the cached thumbnail is valid as long as the file wasn't modified since
+        QImageReader cached(file, "png");
+        if (cached.canRead() && cached.text(QStringLiteral("Thumb::URI")) == uri &&
+            cached.text(QStringLiteral("Thumb::MTime")) == mtime) {
+            QImage image = cached.read();
+            if (!image.isNull()) {
+                return scaled(image);
+            }
+        }
+
+        QImageReader reader(m_path);
+        QSize imageSize = reader.size();
+        if (!imageSize.isValid()) {
+            return QImage();
+        }
+        // the jpeg decoder can scale down while decoding, which is a lot faster than decoding
+        // the full image. small images are not scaled up, and not worth caching either.
+        bool small = imageSize.width() <= size && imageSize.height() <= size;
+        if (!small) {
+            reader.setScaledSize(imageSize.scaled(size, size, Qt::KeepAspectRatio));
+        }
+        QImage image = reader.read();
+        if (image.isNull() || m_cancelled->load() || small) {
+            return scaled(image);
+        }
+
+        image.setText(QStringLiteral("Thumb::URI"), uri);
+        image.setText(QStringLiteral("Thumb::MTime"), mtime);
+        QDir().mkpath(QFileInfo(file).path());
+        QSaveFile out(file);
+        if (!out.open(QIODevice::WriteOnly) || !image.save(&out, "PNG") || !out.commit()) {
+            qWarning("ThumbnailProvider: failed to write '%s'.", qPrintable(file));
+        } else {
+            // the spec wants the thumbnails to be private
+            QFile::setPermissions(file, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+        }
+        return scaled(image);
+    }
+
+    QImage scaled(const QImage &image) const
+    {
+        if (image.isNull() || !m_requestedSize.isValid() ||
+            (image.width() <= m_requestedSize.width() && image.height() <= m_requestedSize.height())) {
+            return image;
+        }
+        return image.scaled(m_requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    QString m_path;
+    QSize m_requestedSize;
+    QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+class ThumbnailResponse : public QQuickImageResponse
+{
+public:
+    ThumbnailResponse(const QString &path, const QSize &requestedSize, QThreadPool *pool)
+        : m_cancelled(new QAtomicInt(0))
+    {
+        ThumbnailTask *task = new ThumbnailTask(path, requestedSize, m_cancelled);
+        connect(task, &ThumbnailTask::done, this, [this](const QImage &image) {
+            m_image = image;
+            emit finished();
+        });
+        pool->start(task);
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    void cancel() override
+    {
+        m_cancelled->store(1);
+    }
+
+private:
+    QImage m_image;
+    QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+ThumbnailProvider::ThumbnailProvider()
+                 : QQuickAsyncImageProvider()
+{
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+}
+
+QQuickImageResponse *ThumbnailProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    return new ThumbnailResponse(QUrl::fromPercentEncoding(id.toUtf8()), requestedSize, &m_pool);
+}
+
+#include "thumbnailprovider.moc"
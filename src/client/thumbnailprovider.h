@@ -0,0 +1,43 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THUMBNAILPROVIDER_H
+#define THUMBNAILPROVIDER_H
+
+#include <QQuickImageProvider>
+#include <QThreadPool>
+
+/*
+ * Provides downscaled previews of image files, as image://thumbnail/<percent encoded path>.
+ * The images are decoded in parallel in a thread pool, asking the decoder to scale them
+ * down while decoding, and the thumbnails are cached on disk in the freedesktop.org
+ * thumbnails directory, so that they are shared with the other applications.
+ */
+class ThumbnailProvider : public QQuickAsyncImageProvider
+{
+public:
+    ThumbnailProvider();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+private:
+    QThreadPool m_pool;
+};
+
+#endif
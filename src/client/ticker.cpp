@@ -0,0 +1,147 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include <QSocketNotifier>
+#include <QMetaMethod>
+#include <QDebug>
+
+#include "ticker.h"
+#include "client.h"
+
+#ifndef TFD_TIMER_CANCEL_ON_SET
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#endif
+
+Ticker::Ticker()
+      : QObject()
+      , m_fd(timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC))
+      , m_notifier(nullptr)
+      , m_paused(false)
+      , m_lastMinute(-1)
+{
+    if (m_fd < 0) {
+        qWarning("Ticker: cannot create the timerfd: %m");
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &Ticker::timeout);
+
+    Client *client = Client::client();
+    m_paused = client->isSessionLocked();
+    connect(client, &Client::locked, this, [this]() {
+        m_paused = true;
+        rearm();
+    });
+    connect(client, &Client::unlocked, this, [this]() {
+        m_paused = false;
+        m_lastMinute = -1;
+        tick();
+        rearm();
+    });
+}
+
+Ticker::~Ticker()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+Ticker *Ticker::instance()
+{
+    static Ticker *ticker = new Ticker;
+    return ticker;
+}
+
+void Ticker::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&Ticker::second) || signal == QMetaMethod::fromSignal(&Ticker::minute)) {
+        rearm();
+    }
+}
+
+void Ticker::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&Ticker::second) || signal == QMetaMethod::fromSignal(&Ticker::minute)) {
+        rearm();
+    }
+}
+
+void Ticker::rearm()
+{
+    if (m_fd < 0) {
+        return;
+    }
+
+    itimerspec spec = {};
+    if (!m_paused) {
+        int interval = 0;
+        if (isSignalConnected(QMetaMethod::fromSignal(&Ticker::second))) {
+            interval = 1;
+        } else if (isSignalConnected(QMetaMethod::fromSignal(&Ticker::minute))) {
+            interval = 60;
+        }
+
+        if (interval > 0) {
+            timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            spec.it_value.tv_sec = (now.tv_sec / interval + 1) * interval;
+            spec.it_interval.tv_sec = interval;
+        }
+    }
+
+    // with the cancel flag the read fails with ECANCELED when the clock is changed
+    if (timerfd_settime(m_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) < 0) {
+        qWarning("Ticker: cannot arm the timerfd: %m");
+    }
+}
+
+void Ticker::timeout()
+{
+    uint64_t expirations;
+    if (read(m_fd, &expirations, sizeof(expirations)) < 0) {
+        if (errno == ECANCELED) {
+            emit clockChanged();
+            m_lastMinute = -1;
+            tick();
+            rearm();
+        }
+        return;
+    }
+
+    tick();
+}
+
+void Ticker::tick()
+{
+    emit second();
+
+    // the timer may fire a bit late, so don't check for the exact boundary
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (now.tv_sec / 60 != m_lastMinute) {
+        m_lastMinute = now.tv_sec / 60;
+        emit minute();
+    }
+}
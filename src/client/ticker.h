@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TICKER_H
+#define TICKER_H
+
+#include <QObject>
+
+class QSocketNotifier;
+
+/*
+ * A wall clock ticker shared by everything in the shell that needs to be updated
+ * periodically. The ticks are aligned to the second and minute boundaries and the
+ * timer is only armed for the finest interval someone is connected to, so nothing
+ * wakes up the shell when nobody is listening. The ticker is paused while the
+ * session is locked, and it ticks right away when unlocked or when the wall clock
+ * is changed.
+ */
+class Ticker : public QObject
+{
+    Q_OBJECT
+public:
+    static Ticker *instance();
+
+signals:
+    void second();
+    void minute();
+    /**
+     * Emitted when the wall clock jumps, e.g. when it is set manually or by ntp.
+     */
+    void clockChanged();
+
+protected:
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
+private:
+    Ticker();
+    ~Ticker();
+
+    void rearm();
+    void timeout();
+    void tick();
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    bool m_paused;
+    qint64 m_lastMinute;
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include <QScreen>
 #include <QTimer>
 #include <QJsonArray>
+#include <QElapsedTimer>
 
 #include "client.h"
 #include "element.h"
@@ -42,7 +43,17 @@ UiScreen::UiScreen(ShellUI *ui, Client *client, QScreen *screen, const QString &
        , m_name(name)
        , m_screen(screen)
        , m_loading(true)
+       , m_stats(qEnvironmentVariableIsSet("ORBITAL_SCREEN_STATS"))
 {
+    m_frameStats.frames = 0;
+    m_frameStats.totalTime = 0;
+    m_frameStats.maxTime = 0;
+
+    if (m_stats) {
+        QTimer *timer = new QTimer(this);
+        connect(timer, &QTimer::timeout, this, &UiScreen::reportStats);
+        timer->start(30000);
+    }
 }
 
 UiScreen::~UiScreen()
@@ -88,8 +99,10 @@ void UiScreen::loadConfig(QJsonObject &config)
                 p = new Panel(m_screen, elm);
             }
             p->setLocation(elm->location());
+            trackWindow(p);
         } else {
             QQuickWindow *window = m_client->window(elm);
+            trackWindow(window);
 
             connect(m_screen, &QObject::destroyed, [window]() { delete window; });
             connect(elm, &QObject::destroyed, window, &QObject::deleteLater);
@@ -282,4 +295,49 @@ void UiScreen::screenLoaded()
 {
     m_loading = false;
     emit loaded();
+    if (m_stats) {
+        reportStats();
+    }
+}
+
+void UiScreen::trackWindow(QQuickWindow *window)
+{
+    if (!m_stats || m_windows.contains(window)) {
+        return;
+    }
+
+    m_windows << window;
+    connect(window, &QObject::destroyed, this, [this, window]() { m_windows.removeOne(window); });
+
+    // the timer is only touched by the thread rendering this window
+    QElapsedTimer *timer = new QElapsedTimer;
+    connect(window, &QObject::destroyed, [timer]() { delete timer; });
+    connect(window, &QQuickWindow::beforeRendering, window, [timer]() { timer->start(); }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering, this, [this, timer]() {
+        qint64 time = timer->nsecsElapsed();
+        ++m_frameStats.frames;
+        m_frameStats.totalTime += time;
+        qint64 max = m_frameStats.maxTime;
+        while (time > max && !m_frameStats.maxTime.compare_exchange_weak(max, time)) {
+        }
+    }, Qt::DirectConnection);
+}
+
+void UiScreen::reportStats()
+{
+    qint64 bufferSize = 0;
+    for (QQuickWindow *w: m_windows) {
+        if (w->isVisible()) {
+            qreal dpr = w->devicePixelRatio();
+            // assume double buffering
+            bufferSize += 2 * 4 * qint64(w->width() * dpr) * qint64(w->height() * dpr);
+        }
+    }
+
+    int frames = m_frameStats.frames.exchange(0);
+    qint64 totalTime = m_frameStats.totalTime.exchange(0);
+    qint64 maxTime = m_frameStats.maxTime.exchange(0);
+    qDebug("Screen %s: %d element windows, about %lld KiB of buffers. %d frames rendered, %.2f ms on average, %.2f ms max.",
+           qPrintable(m_name), m_windows.count(), bufferSize / 1024, frames,
+           frames ? totalTime / frames / 1e6 : 0., maxTime / 1e6);
 }
@@ -20,6 +20,8 @@
 #ifndef UISCREEN_H
 #define UISCREEN_H
 
+#include <atomic>
+
 #include <QObject>
 #include <QQmlListProperty>
 #include <QStringList>
@@ -28,6 +30,7 @@
 
 class QQmlEngine;
 class QQuickItem;
+class QQuickWindow;
 class QScreen;
 
 class Element;
@@ -70,6 +73,8 @@ private:
     void saveProperties(QObject *obj, const QStringList &properties, QJsonObject &config);
     void saveChildren(const QList<Element *> &children, QJsonObject &config);
     void elementDestroyed(QObject *obj);
+    void trackWindow(QQuickWindow *window);
+    void reportStats();
 
     Client *m_client;
     ShellUI *m_ui;
@@ -77,9 +82,19 @@ private:
     QScreen *m_screen;
     QRect m_rect;
     bool m_loading;
+    bool m_stats;
 
     QHash<int, Element *> m_elements;
     QList<Element *> m_children;
+
+    // written by the render threads of the windows
+    struct FrameStats {
+        std::atomic<int> frames;
+        std::atomic<qint64> totalTime;
+        std::atomic<qint64> maxTime;
+    };
+    FrameStats m_frameStats;
+    QList<QQuickWindow *> m_windows;
 };
 
 #endif
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+
+#include <QGuiApplication>
+#include <QScreen>
+#include <QImageReader>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QUrl>
+#include <QDebug>
+
+#include "wallpaperprovider.h"
+
+// the values of QML's Image.fillMode
+enum FillMode {
+    Stretch = 0,
+    PreserveAspectFit = 1,
+    PreserveAspectCrop = 2,
+    Tile = 3,
+    Pad = 6
+};
+
+// owned by the pool, it only talks to the response through a connection, which
+// goes away if QML deletes the response first
+class WallpaperTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    WallpaperTask(WallpaperProvider *provider, const QString &path, int fillMode, const QSize &size,
+                  const QSharedPointer<QAtomicInt> &cancelled)
+        : m_provider(provider)
+        , m_path(path)
+        , m_fillMode(fillMode)
+        , m_size(size)
+        , m_cancelled(cancelled)
+    {
+    }
+
+    void run() override
+    {
+        emit done(m_cancelled->load() ? QImage() : m_provider->wallpaper(m_path, m_fillMode, m_size));
+    }
+
+signals:
+    void done(const QImage &image);
+
+private:
+    WallpaperProvider *m_provider;
+    QString m_path;
+    int m_fillMode;
+    QSize m_size;
+    QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+class WallpaperResponse : public QQuickImageResponse
+{
+public:
+    WallpaperResponse(WallpaperTask *task, const QSharedPointer<QAtomicInt> &cancelled)
+        : m_cancelled(cancelled)
+    {
+        connect(task, &WallpaperTask::done, this, [this](const QImage &image) {
+            m_image = image;
+            emit finished();
+        });
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    void cancel() override
+    {
+        m_cancelled->store(1);
+    }
+
+private:
+    QImage m_image;
+    QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+WallpaperProvider::WallpaperProvider()
+                 : QQuickAsyncImageProvider()
+                 , m_sources(MaxCost)
+                 , m_maxPinned(1)
+                 , m_stats(qEnvironmentVariableIsSet("ORBITAL_WALLPAPER_STATS"))
+{
+    m_pool.setMaxThreadCount(1);
+
+    updateScreens();
+    QObject::connect(qGuiApp, &QGuiApplication::screenAdded, qGuiApp, [this]() { updateScreens(); });
+    QObject::connect(qGuiApp, &QGuiApplication::screenRemoved, qGuiApp, [this]() { updateScreens(); });
+}
+
+// the wallpapers are decoded big enough to cover all the screens, make room in
+// the cache for two of them per screen
+void WallpaperProvider::updateScreens()
+{
+    QSize size;
+    const auto screens = QGuiApplication::screens();
+    foreach (QScreen *screen, screens) {
+        size = size.expandedTo(screen->size() * screen->devicePixelRatio());
+    }
+    qint64 cost = qint64(size.width()) * size.height() * 4 * 2 * screens.size();
+
+    QMutexLocker lock(&m_mutex);
+    m_screensSize = size;
+    m_sources.setMaxCost(int(qBound(qint64(MaxCost), cost, qint64(INT_MAX))));
+    m_maxPinned = qMax(1, screens.size());
+    while (m_pinnedOrder.size() > m_maxPinned) {
+        m_pinned.remove(m_pinnedOrder.takeFirst());
+    }
+}
+
+// must be called with the mutex locked
+WallpaperProvider::Source *WallpaperProvider::cached(const QString &path)
+{
+    if (Source *s = m_sources.object(path)) {
+        return s;
+    }
+    auto it = m_pinned.find(path);
+    return it != m_pinned.end() ? &*it : nullptr;
+}
+
+// must be called with the mutex locked
+void WallpaperProvider::remove(const QString &path)
+{
+    m_sources.remove(path);
+    m_pinned.remove(path);
+    m_pinnedOrder.removeOne(path);
+}
+
+// the wallpaper used before by the requester is dropped if no one else uses it
+void WallpaperProvider::setRequested(const QString &requester, const QString &path)
+{
+    QMutexLocker lock(&m_mutex);
+    QString old = m_requested.value(requester);
+    m_requested.insert(requester, path);
+    if (!old.isEmpty() && old != path && m_requested.key(old).isNull()) {
+        remove(old);
+    }
+}
+
+QQuickImageResponse *WallpaperProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    QString requester = id.section(QLatin1Char('/'), 0, 0);
+    int fillMode = id.section(QLatin1Char('/'), 1, 1).toInt();
+    QString path = QUrl::fromPercentEncoding(id.section(QLatin1Char('/'), 2).toUtf8());
+    if (path.startsWith(QLatin1String("file:"))) {
+        path = QUrl(path).toLocalFile();
+    }
+    setRequested(requester, path);
+
+    QSharedPointer<QAtomicInt> cancelled(new QAtomicInt(0));
+    WallpaperTask *task = new WallpaperTask(this, path, fillMode, requestedSize, cancelled);
+    WallpaperResponse *response = new WallpaperResponse(task, cancelled);
+    m_pool.start(task);
+    return response;
+}
+
+QImage WallpaperProvider::wallpaper(const QString &path, int fillMode, const QSize &size)
+{
+    // the tiled and centered wallpapers are not scaled
+    bool fullSize = fillMode != Stretch && fillMode != PreserveAspectFit && fillMode != PreserveAspectCrop;
+    QImage image = source(path, fullSize ? QSize() : size);
+    if (image.isNull() || !size.isValid()) {
+        return image;
+    }
+
+    switch (fillMode) {
+        case Stretch:
+            return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        case PreserveAspectFit:
+            return image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        case PreserveAspectCrop:
+            // the centered part is what is visible
+            image = image.scaled(size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+            // fall through
+        case Pad:
+            if (image.width() > size.width() || image.height() > size.height()) {
+                QSize s = image.size().boundedTo(size);
+                return image.copy((image.width() - s.width()) / 2, (image.height() - s.height()) / 2, s.width(), s.height());
+            }
+            return image;
+        default:
+            return image;
+    }
+}
+
+// the source image, decoded big enough to cover the size and all the screens, or
+// at its full size if the size is not valid
+QImage WallpaperProvider::source(const QString &path, const QSize &size)
+{
+    QDateTime modified = QFileInfo(path).lastModified();
+
+    // the lock is not held while decoding, there is only one thread decoding anyway
+    m_mutex.lock();
+    QSize coverSize = size.isValid() ? size.expandedTo(m_screensSize) : QSize();
+    Source *s = cached(path);
+    if (s && s->modified != modified) {
+        remove(path);
+        s = nullptr;
+    }
+    if (s) {
+        if (s->fullSize || (coverSize.isValid() && s->image.width() >= coverSize.width() &&
+                                                   s->image.height() >= coverSize.height())) {
+            QImage image = s->image;
+            m_mutex.unlock();
+            return image;
+        }
+    }
+    m_mutex.unlock();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    QSize imageSize = reader.size();
+    bool fullSize = true;
+    // the jpeg decoder can scale down while decoding, which is a lot faster than decoding the full image
+    if (imageSize.isValid() && coverSize.isValid()) {
+        QSize scaled = imageSize.scaled(coverSize, Qt::KeepAspectRatioByExpanding);
+        if (scaled.width() < imageSize.width()) {
+            reader.setScaledSize(scaled);
+            fullSize = false;
+        }
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qWarning() << "Failed to load the wallpaper" << path << ":" << reader.errorString();
+        return image;
+    }
+    // the scaling is faster on these formats
+    image = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+
+    QMutexLocker lock(&m_mutex);
+    remove(path);
+    Source source{ image, fullSize, modified };
+    // don't keep it if the background changed wallpaper again while this was decoding
+    if (m_requested.key(path).isNull()) {
+        return image;
+    }
+    if (image.byteCount() > m_sources.maxCost()) {
+        // the cache would drop it right away, making every screen decode it again
+        m_pinned.insert(path, source);
+        m_pinnedOrder << path;
+        while (m_pinnedOrder.size() > m_maxPinned) {
+            m_pinned.remove(m_pinnedOrder.takeFirst());
+        }
+    } else {
+        m_sources.insert(path, new Source(source), image.byteCount());
+    }
+    if (m_stats) {
+        qDebug() << "Decoded the wallpaper" << path << "at" << image.size() << "in" << timer.elapsed() << "ms,"
+                 << m_sources.totalCost() / 1024 << "KiB used by the cached wallpapers," << m_pinned.size() << "too big for the cache.";
+    }
+    return image;
+}
+
+#include "wallpaperprovider.moc"
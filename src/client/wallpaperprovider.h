@@ -0,0 +1,78 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WALLPAPERPROVIDER_H
+#define WALLPAPERPROVIDER_H
+
+#include <QQuickImageProvider>
+#include <QThreadPool>
+#include <QCache>
+#include <QHash>
+#include <QStringList>
+#include <QMutex>
+#include <QDateTime>
+
+/*
+ * Provides the wallpapers, as image://wallpaper/<requester>/<fill mode>/<percent encoded path>,
+ * already scaled to the requested size according to the fill mode of QML's Image. Every
+ * wallpaper is decoded once at the size needed by the biggest screen and shared by all the
+ * screens using it, until the file changes, and the scaling is done in a worker thread.
+ * The requester is an id of the background asking for the wallpaper, a wallpaper is dropped
+ * as soon as no requester uses it anymore. The cache grows with the screens, and the wallpapers
+ * too big for it are kept anyway, as many as the screens, so that they are not decoded again
+ * for every screen.
+ */
+class WallpaperProvider : public QQuickAsyncImageProvider
+{
+public:
+    static const int MaxCost = 64 << 20;
+
+    WallpaperProvider();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+    QImage wallpaper(const QString &path, int fillMode, const QSize &size);
+    void setRequested(const QString &requester, const QString &path);
+
+private:
+    struct Source {
+        QImage image;
+        bool fullSize;
+        QDateTime modified;
+    };
+
+    QImage source(const QString &path, const QSize &size);
+    Source *cached(const QString &path);
+    void remove(const QString &path);
+    void updateScreens();
+
+    // only one thread, so that the screens asking for the same wallpaper wait for the first decode
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QCache<QString, Source> m_sources;
+    QHash<QString, Source> m_pinned;
+    QStringList m_pinnedOrder;
+    int m_maxPinned;
+    QSize m_screensSize;
+    // the wallpaper used by every requester
+    QHash<QString, QString> m_requested;
+    bool m_stats;
+};
+
+#endif
@@ -113,6 +113,15 @@ bool Window::isMinimized() const
     return m_state & Minimized;
 }
 
+desktop_shell_window_thumbnail *Window::getThumbnail(const QSize &maxSize)
+{
+    // an older compositor has no thumbnails
+    if (wl_proxy_get_version((wl_proxy *)m_window) < DESKTOP_SHELL_WINDOW_GET_THUMBNAIL_SINCE_VERSION) {
+        return nullptr;
+    }
+    return desktop_shell_window_get_thumbnail(m_window, maxSize.width(), maxSize.height());
+}
+
 void Window::close()
 {
     desktop_shell_window_close(m_window);
@@ -21,9 +21,11 @@
 #define WINDOW_H
 
 #include <QObject>
+#include <QSize>
 
 struct desktop_shell_window;
 struct desktop_shell_window_listener;
+struct desktop_shell_window_thumbnail;
 
 class UiScreen;
 
@@ -60,6 +62,9 @@ public:
     Q_INVOKABLE bool isActive() const;
     Q_INVOKABLE bool isMinimized() const;
 
+    // null if the compositor is too old to make thumbnails
+    desktop_shell_window_thumbnail *getThumbnail(const QSize &maxSize);
+
 public slots:
     void close();
     void preview(UiScreen *screen);
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <QDebug>
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+
+#include <wayland-client.h>
+
+#include "windowthumbnail.h"
+#include "window.h"
+#include "client.h"
+#include "utils.h"
+
+#include "wayland-desktop-shell-client-protocol.h"
+
+static int createAnonymousFile(size_t size)
+{
+    QByteArray path = qgetenv("XDG_RUNTIME_DIR") + "/orbital-thumbnail-XXXXXX";
+    int fd = mkostemp(path.data(), O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path.constData());
+
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+const desktop_shell_window_thumbnail_listener WindowThumbnail::s_listener = {
+    wrapInterface(&WindowThumbnail::handleConfigure),
+    wrapInterface(&WindowThumbnail::handleUpdated)
+};
+
+WindowThumbnail::WindowThumbnail(QQuickItem *parent)
+               : QQuickItem(parent)
+               , m_window(nullptr)
+               , m_sourceSize(200, 200)
+               , m_thumbnail(nullptr)
+               , m_buffer(nullptr)
+               , m_data(nullptr)
+               , m_dataSize(0)
+               , m_imageChanged(false)
+{
+    setFlag(QQuickItem::ItemHasContents);
+}
+
+WindowThumbnail::~WindowThumbnail()
+{
+    destroy();
+}
+
+void WindowThumbnail::setShellWindow(Window *w)
+{
+    if (m_window == w) {
+        return;
+    }
+
+    destroy();
+    if (m_window) {
+        disconnect(m_window, nullptr, this, nullptr);
+    }
+    m_window = w;
+    if (m_window) {
+        connect(m_window, &Window::destroyed, this, [this]() { setShellWindow(nullptr); });
+    }
+    create();
+
+    m_image = QImage();
+    m_imageChanged = true;
+    update();
+    emit shellWindowChanged();
+}
+
+void WindowThumbnail::setSourceSize(const QSize &size)
+{
+    if (m_sourceSize == size) {
+        return;
+    }
+
+    m_sourceSize = size;
+    destroy();
+    create();
+    emit sourceSizeChanged();
+}
+
+void WindowThumbnail::create()
+{
+    if (!m_window || m_sourceSize.isEmpty()) {
+        return;
+    }
+
+    m_thumbnail = m_window->getThumbnail(m_sourceSize);
+    if (!m_thumbnail) {
+        return;
+    }
+    desktop_shell_window_thumbnail_add_listener(m_thumbnail, &s_listener, this);
+}
+
+void WindowThumbnail::destroy()
+{
+    if (m_thumbnail) {
+        desktop_shell_window_thumbnail_destroy(m_thumbnail);
+        m_thumbnail = nullptr;
+    }
+    destroyBuffer();
+}
+
+void WindowThumbnail::createBuffer(const QSize &size)
+{
+    destroyBuffer();
+
+    int stride = size.width() * 4;
+    m_dataSize = stride * size.height();
+    int fd = createAnonymousFile(m_dataSize);
+    if (fd < 0) {
+        qWarning("WindowThumbnail: cannot create a buffer of %d bytes: %m", (int)m_dataSize);
+        return;
+    }
+
+    m_data = mmap(nullptr, m_dataSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (m_data == MAP_FAILED) {
+        m_data = nullptr;
+        close(fd);
+        return;
+    }
+
+    wl_shm_pool *pool = wl_shm_create_pool(Client::client()->shm(), fd, m_dataSize);
+    m_buffer = wl_shm_pool_create_buffer(pool, 0, size.width(), size.height(), stride, WL_SHM_FORMAT_ARGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+    m_bufferSize = size;
+}
+
+void WindowThumbnail::destroyBuffer()
+{
+    if (m_buffer) {
+        wl_buffer_destroy(m_buffer);
+        m_buffer = nullptr;
+    }
+    if (m_data) {
+        munmap(m_data, m_dataSize);
+        m_data = nullptr;
+    }
+}
+
+void WindowThumbnail::handleConfigure(desktop_shell_window_thumbnail *thumbnail, int32_t width, int32_t height)
+{
+    createBuffer(QSize(width, height));
+    if (m_buffer) {
+        desktop_shell_window_thumbnail_attach(m_thumbnail, m_buffer);
+    }
+}
+
+void WindowThumbnail::handleUpdated(desktop_shell_window_thumbnail *thumbnail)
+{
+    if (!m_buffer) {
+        return;
+    }
+
+    // the buffer is ours until we attach it again, so copy it out before doing that
+    m_image = QImage(static_cast<const uchar *>(m_data), m_bufferSize.width(), m_bufferSize.height(),
+                     m_bufferSize.width() * 4, QImage::Format_ARGB32_Premultiplied).copy();
+    m_imageChanged = true;
+    desktop_shell_window_thumbnail_attach(m_thumbnail, m_buffer);
+
+    setImplicitSize(m_bufferSize.width(), m_bufferSize.height());
+    update();
+}
+
+QSGNode *WindowThumbnail::updatePaintNode(QSGNode *old, UpdatePaintNodeData *)
+{
+    QSGSimpleTextureNode *node = static_cast<QSGSimpleTextureNode *>(old);
+    if (m_image.isNull()) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = new QSGSimpleTextureNode;
+        node->setOwnsTexture(true);
+        node->setFiltering(QSGTexture::Linear);
+    }
+    if (m_imageChanged) {
+        node->setTexture(window()->createTextureFromImage(m_image));
+        m_imageChanged = false;
+    }
+
+    QSizeF size = QSizeF(m_image.size()).scaled(width(), height(), Qt::KeepAspectRatio);
+    node->setRect(QRectF(QPointF((width() - size.width()) / 2., (height() - size.height()) / 2.), size));
+    return node;
+}
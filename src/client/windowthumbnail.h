@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WINDOWTHUMBNAIL_H
+#define WINDOWTHUMBNAIL_H
+
+#include <QQuickItem>
+#include <QImage>
+
+struct wl_buffer;
+struct desktop_shell_window_thumbnail;
+struct desktop_shell_window_thumbnail_listener;
+
+class Window;
+
+class WindowThumbnail : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(Window *window READ shellWindow WRITE setShellWindow NOTIFY shellWindowChanged)
+    Q_PROPERTY(QSize sourceSize READ sourceSize WRITE setSourceSize NOTIFY sourceSizeChanged)
+public:
+    explicit WindowThumbnail(QQuickItem *parent = nullptr);
+    ~WindowThumbnail();
+
+    Window *shellWindow() const { return m_window; }
+    void setShellWindow(Window *window);
+
+    QSize sourceSize() const { return m_sourceSize; }
+    void setSourceSize(const QSize &size);
+
+signals:
+    void shellWindowChanged();
+    void sourceSizeChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *node, UpdatePaintNodeData *data) override;
+
+private:
+    void create();
+    void destroy();
+    void createBuffer(const QSize &size);
+    void destroyBuffer();
+    void handleConfigure(desktop_shell_window_thumbnail *thumbnail, int32_t width, int32_t height);
+    void handleUpdated(desktop_shell_window_thumbnail *thumbnail);
+
+    Window *m_window;
+    QSize m_sourceSize;
+    desktop_shell_window_thumbnail *m_thumbnail;
+    wl_buffer *m_buffer;
+    void *m_data;
+    size_t m_dataSize;
+    QSize m_bufferSize;
+    QImage m_image;
+    bool m_imageChanged;
+
+    static const desktop_shell_window_thumbnail_listener s_listener;
+};
+
+#endif
@@ -18,17 +18,47 @@
  */
 
 #include <functional>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
 
 #include <QDebug>
 
 #include "authorizer.h"
 #include "compositor.h"
 #include "utils.h"
+#include "timer.h"
 #include "wayland-authorizer-server-protocol.h"
 #include "wayland-authorizer-helper-server-protocol.h"
 
 namespace Orbital {
 
+// how long a decision by the helper is reused for other instances of the same executable
+static const std::chrono::minutes GrantedTtl(10);
+static const std::chrono::seconds DeniedTtl(30);
+// how long to wait for the helper before denying, it is not cached
+static const int DecisionTimeout = 60000;
+// the result given when the helper went away or didn't answer in time
+static const int32_t NoAnswer = -1;
+
+/*
+ * The cache key for the decisions, or an empty string if the executable of the process
+ * cannot be found. The inode is part of the key so that replacing the executable
+ * invalidates the decisions taken for the old one.
+ */
+static std::string decisionKey(pid_t pid, const std::string &interface)
+{
+    std::string link = "/proc/" + std::to_string(pid) + "/exe";
+    char path[PATH_MAX];
+    ssize_t len = readlink(link.c_str(), path, sizeof(path));
+    struct stat st;
+    if (len <= 0 || len == sizeof(path) || stat(link.c_str(), &st) != 0) {
+        return std::string();
+    }
+
+    return interface + '\n' + std::string(path, len) + '\n' + std::to_string(st.st_dev) + ':' + std::to_string(st.st_ino);
+}
+
 
 class Helper: public Global
 {
@@ -73,13 +103,21 @@ public:
                 static const struct orbital_authorizer_helper_result_interface impl = {
                     wrapInterface(result)
                 };
-                wl_resource_set_implementation(res, &impl, this, nullptr);
+                wl_resource_set_implementation(res, &impl, this, [](wl_resource *r) {
+                    Request *req = static_cast<Request *>(wl_resource_get_user_data(r));
+                    // the helper died before answering
+                    if (req->callback) {
+                        req->callback(NoAnswer);
+                    }
+                    delete req;
+                });
             }
             void result(int32_t result)
             {
-                callback(result);
+                auto cb = std::move(callback);
+                callback = nullptr;
+                cb(result);
                 wl_resource_destroy(res);
-                delete this;
             }
 
             wl_resource *res;
@@ -133,6 +171,7 @@ public:
 Authorizer::Authorizer(Compositor *compositor)
           : QObject(compositor)
           , Global(compositor, &orbital_authorizer_interface, 1)
+          , m_pendingSerial(0)
           , m_helper(new Helper(compositor, this))
 {
 }
@@ -144,20 +183,26 @@ Authorizer::~Authorizer()
 
 void Authorizer::addRestrictedInterface(StringView interface)
 {
-    if (std::find(m_restrictedIfaces.begin(), m_restrictedIfaces.end(), interface) != std::end(m_restrictedIfaces)) {
-        return;
-    }
-    m_restrictedIfaces.push_back(interface.toStdString());
+    m_restrictedIfaces.insert(interface.toStdString());
 }
 
 void Authorizer::removeRestrictedInterface(StringView interface)
 {
-    for (auto i = m_restrictedIfaces.begin(); i != m_restrictedIfaces.end(); ++i) {
-        if (*i == interface) {
-            m_restrictedIfaces.erase(i);
-            return;
+    m_restrictedIfaces.erase(interface.toStdString());
+    revoke(interface);
+}
+
+void Authorizer::revoke(StringView interface)
+{
+    std::string prefix = interface.toStdString() + '\n';
+    for (auto it = m_decisions.begin(); it != m_decisions.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = m_decisions.erase(it);
+        } else {
+            ++it;
         }
     }
+    m_trustedClients.erase(interface.toStdString());
 }
 
 void Authorizer::addTrustedClient(StringView interface, wl_client *c)
@@ -215,7 +260,8 @@ void Authorizer::authorize(wl_client *client, wl_resource *res, uint32_t id, con
 {
     wl_resource *resource = wl_resource_create(client, &orbital_authorizer_feedback_interface, wl_resource_get_version(res), id);
 
-    if (std::find(m_restrictedIfaces.begin(), m_restrictedIfaces.end(), global) == std::end(m_restrictedIfaces)) {
+    std::string iface = global; //take a copy or 'global' may become invalid when the callback runs
+    if (m_restrictedIfaces.find(iface) == m_restrictedIfaces.end()) {
         qDebug("Authorization request for unknown interface '%s'. Granting...", global);
         grant(resource);
         return;
@@ -224,19 +270,94 @@ void Authorizer::authorize(wl_client *client, wl_resource *res, uint32_t id, con
     pid_t pid;
     wl_client_get_credentials(client, &pid, nullptr, nullptr);
 
+    std::string key = decisionKey(pid, iface);
+    bool cache = !key.empty();
+    if (cache) {
+        auto it = m_decisions.find(key);
+        if (it != m_decisions.end() && it->second.expiry > std::chrono::steady_clock::now()) {
+            qDebug("Authorization for global '%s' requested by process %d, using the cached decision.", global, pid);
+            if (it->second.result == 1) {
+                grant(resource);
+                addTrustedClient(iface, client);
+            } else {
+                deny(resource);
+            }
+            return;
+        } else if (it != m_decisions.end()) {
+            m_decisions.erase(it);
+        }
+    } else {
+        // can't cache this, but still batch the requests coming from the same process
+        key = iface + '\n' + std::to_string(pid);
+    }
+
+    // the client may go away before the helper answers
+    wl_resource_set_implementation(resource, nullptr, this, [](wl_resource *r) {
+        Authorizer *_this = static_cast<Authorizer *>(wl_resource_get_user_data(r));
+        for (auto &p: _this->m_pendingDecisions) {
+            auto &resources = p.second.resources;
+            auto it = std::find(resources.begin(), resources.end(), r);
+            if (it != resources.end()) {
+                resources.erase(it);
+                return;
+            }
+        }
+    });
+
+    auto &pending = m_pendingDecisions[key];
+    pending.resources.push_back(resource);
+    if (pending.resources.size() > 1) {
+        qDebug("Authorization for global '%s' requested by process %d, waiting for the pending one.", global, pid);
+        return;
+    }
+
+    // don't let the requests for this key wait forever if the helper hangs
+    uint32_t serial = ++m_pendingSerial;
+    pending.serial = serial;
+    Timer::singleShot(DecisionTimeout, [this, key, iface, serial]() {
+        auto it = m_pendingDecisions.find(key);
+        if (it != m_pendingDecisions.end() && it->second.serial == serial) {
+            decided(key, iface, false, NoAnswer);
+        }
+    });
+
     qDebug("Authorization for global '%s' requested by process %d.", global, pid);
+    m_helper->authRequested(global, pid, [this, key, iface, cache](int32_t result) {
+        decided(key, iface, cache, result);
+    });
+}
 
-    std::string iface = global; //take a copy or 'global' may become invalid when the callback runs
-    m_helper->authRequested(global, pid, [this, iface, client, resource](int32_t result) {
+void Authorizer::decided(const std::string &key, const std::string &interface, bool cache, int32_t result)
+{
+    if (result == 1) {
+        qDebug("Authorization granted.");
+    } else if (result == NoAnswer) {
+        qDebug("Authorization helper gave no answer, denying.");
+        cache = false;
+    } else {
+        qDebug("Authorization denied.");
+    }
+    if (cache) {
+        auto ttl = result == 1 ? std::chrono::steady_clock::duration(GrantedTtl) : std::chrono::steady_clock::duration(DeniedTtl);
+        m_decisions[key] = { result, std::chrono::steady_clock::now() + ttl };
+    }
+
+    auto it = m_pendingDecisions.find(key);
+    if (it == m_pendingDecisions.end()) {
+        return;
+    }
+    std::vector<wl_resource *> resources = std::move(it->second.resources);
+    m_pendingDecisions.erase(it);
+
+    for (wl_resource *resource: resources) {
+        wl_client *client = wl_resource_get_client(resource);
         if (result == 1) {
-            qDebug("Authorization granted.");
             grant(resource);
-            addTrustedClient(iface, client);
+            addTrustedClient(interface, client);
         } else {
-            qDebug("Authorization denied.");
             deny(resource);
         }
-    });
+    }
 }
 
 void Authorizer::grant(wl_resource *res)
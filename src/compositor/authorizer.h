@@ -25,7 +25,9 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <list>
+#include <chrono>
 
 #include "interface.h"
 #include "stringview.h"
@@ -48,6 +50,11 @@ public:
     void removeRestrictedInterface(StringView interface);
 
     bool isClientTrusted(StringView interface, wl_client *c) const;
+    /**
+     * Forget the cached decisions and the trusted clients for the interface,
+     * so that the next bind needs a new authorization.
+     */
+    void revoke(StringView interface);
 
 protected:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
@@ -58,9 +65,23 @@ private:
     void grant(wl_resource *res);
     void deny(wl_resource *res);
     void addTrustedClient(StringView interface, wl_client *c);
+    void decided(const std::string &key, const std::string &interface, bool cache, int32_t result);
 
-    std::vector<std::string> m_restrictedIfaces;
+    struct Decision {
+        int32_t result;
+        std::chrono::steady_clock::time_point expiry;
+    };
+
+    std::unordered_set<std::string> m_restrictedIfaces;
     std::unordered_map<std::string, std::list<TrustedClient>> m_trustedClients;
+    // keyed by interface, executable path and inode
+    std::unordered_map<std::string, Decision> m_decisions;
+    struct PendingDecision {
+        std::vector<wl_resource *> resources;
+        uint32_t serial;
+    };
+    std::unordered_map<std::string, PendingDecision> m_pendingDecisions;
+    uint32_t m_pendingSerial;
     Helper *m_helper;
 };
 
@@ -20,6 +20,7 @@
 #include <QDebug>
 
 #include "clipboard.h"
+#include "clipboardhistory.h"
 #include "shell.h"
 #include "seat.h"
 #include "compositor.h"
@@ -32,7 +33,11 @@ namespace Orbital {
 ClipboardManager::ClipboardManager(Shell *shell)
                 : Interface(shell)
                 , Global(shell->compositor(), &orbital_clipboard_manager_interface, 1)
+                , m_history(new ClipboardHistory(shell->compositor()))
 {
+    m_selectionTimer.setRepeat(false);
+    m_selectionTimer.setTimeoutHandler([this]() { sendSelection(); });
+
     Compositor *c = shell->compositor();
     for (Seat *s: c->seats()) {
         connect(s, &Seat::selection, this, &ClipboardManager::selection);
@@ -44,12 +49,14 @@ ClipboardManager::ClipboardManager(Shell *shell)
 
 ClipboardManager::~ClipboardManager()
 {
+    delete m_history;
 }
 
 void ClipboardManager::bind(wl_client *client, uint32_t version, uint32_t id)
 {
     static const struct orbital_clipboard_manager_interface implementation = {
-        wrapInterface(destroy)
+        wrapInterface(destroy),
+        wrapInterface(getHistory)
     };
 
     wl_resource *resource = wl_resource_create(client, &orbital_clipboard_manager_interface, version, id);
@@ -68,16 +75,104 @@ void ClipboardManager::destroy(wl_client *client, wl_resource *res)
     wl_resource_destroy(res);
 }
 
+void ClipboardManager::getHistory(wl_client *client, wl_resource *res, uint32_t id)
+{
+    class History : public QObject
+    {
+    public:
+        History(ClipboardHistory *h, wl_resource *r)
+            : history(h)
+            , resource(r)
+        {
+            connect(h, &ClipboardHistory::entryAdded, this, [this](const ClipboardHistory::Entry &e) {
+                std::string preview = ClipboardHistory::preview(e);
+                orbital_clipboard_history_send_entry_added(resource, e.id, preview.c_str(), e.mimeType.c_str(), e.size);
+            });
+            connect(h, &ClipboardHistory::entryRemoved, this, [this](uint32_t id) {
+                orbital_clipboard_history_send_entry_removed(resource, id);
+            });
+            connect(h, &ClipboardHistory::currentChanged, this, [this](uint32_t id) {
+                orbital_clipboard_history_send_current(resource, id);
+            });
+        }
+        void destroy(wl_client *c, wl_resource *r)
+        {
+            wl_resource_destroy(r);
+        }
+        void list(wl_client *c, wl_resource *r, uint32_t start, uint32_t count)
+        {
+            const std::list<ClipboardHistory::Entry> &entries = history->entries();
+            uint32_t i = 0;
+            for (auto it = entries.begin(); it != entries.end() && i < start + count; ++it, ++i) {
+                if (i >= start) {
+                    std::string preview = ClipboardHistory::preview(*it);
+                    orbital_clipboard_history_send_entry(r, it->id, preview.c_str(), it->mimeType.c_str(), it->size);
+                }
+            }
+            orbital_clipboard_history_send_listed(r, entries.size());
+        }
+        void receive(wl_client *c, wl_resource *r, uint32_t entry, int32_t fd)
+        {
+            history->send(entry, fd);
+        }
+        void activate(wl_client *c, wl_resource *r, uint32_t entry)
+        {
+            history->activate(entry);
+        }
+        void remove(wl_client *c, wl_resource *r, uint32_t entry)
+        {
+            history->remove(entry);
+        }
+
+        ClipboardHistory *history;
+        wl_resource *resource;
+    };
+
+    static const struct orbital_clipboard_history_interface implementation = {
+        wrapExtInterface(&History::destroy),
+        wrapExtInterface(&History::list),
+        wrapExtInterface(&History::receive),
+        wrapExtInterface(&History::activate),
+        wrapExtInterface(&History::remove)
+    };
+
+    wl_resource *resource = wl_resource_create(client, &orbital_clipboard_history_interface, wl_resource_get_version(res), id);
+    History *history = new History(m_history, resource);
+    wl_resource_set_implementation(resource, &implementation, history, [](wl_resource *r) {
+        delete static_cast<History *>(wl_resource_get_user_data(r));
+    });
+
+    orbital_clipboard_history_send_current(resource, m_history->current());
+}
+
 void ClipboardManager::selection(Seat *seat)
 {
-    auto selectionClient = seat->selectionClient();
-    for (wl_resource *r: m_resources) {
-        auto client = wl_resource_get_client(r);
-        // don't send the selection back to the clipboard client
-        if (selectionClient != client) {
-            seat->sendSelection(client);
+    // apps setting the selection many times in a row would make us send it over and over
+    // to the clipboard clients, only send the last one. This is only a 100 ms debounce,
+    // every clipboard client still gets the selection once it settles.
+    if (std::find(m_pendingSeats.begin(), m_pendingSeats.end(), seat) == m_pendingSeats.end()) {
+        m_pendingSeats.push_back(seat);
+    }
+    m_selectionTimer.start(100);
+}
+
+void ClipboardManager::sendSelection()
+{
+    for (Seat *seat: m_pendingSeats) {
+        // the seat may have gone away while waiting for the timer
+        if (!seat) {
+            continue;
+        }
+        auto selectionClient = seat->selectionClient();
+        for (wl_resource *r: m_resources) {
+            auto client = wl_resource_get_client(r);
+            // don't send the selection back to the clipboard client
+            if (selectionClient != client) {
+                seat->sendSelection(client);
+            }
         }
     }
+    m_pendingSeats.clear();
 }
 
 }
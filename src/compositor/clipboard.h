@@ -22,14 +22,18 @@
 
 #include <vector>
 
+#include <QPointer>
+
 #include <wayland-server.h>
 
 #include "interface.h"
+#include "timer.h"
 
 namespace Orbital {
 
 class Shell;
 class Seat;
+class ClipboardHistory;
 
 class ClipboardManager : public Interface, public Global
 {
@@ -40,9 +44,14 @@ public:
 private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
     void destroy(wl_client *client, wl_resource *resource);
+    void getHistory(wl_client *client, wl_resource *resource, uint32_t id);
     void selection(Seat *seat);
+    void sendSelection();
 
     std::vector<wl_resource *> m_resources;
+    ClipboardHistory *m_history;
+    std::vector<QPointer<Seat>> m_pendingSeats;
+    Timer m_selectionTimer;
 };
 
 }
@@ -0,0 +1,467 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <chrono>
+
+#include <compositor.h>
+
+#include "clipboardhistory.h"
+#include "clipboardtransfer.h"
+#include "compositor.h"
+#include "seat.h"
+#include "timer.h"
+#include "debug.h"
+#include "utils.h"
+
+namespace Orbital {
+
+static const char *const s_textMimeTypes[] = {
+    "text/plain;charset=utf-8",
+    "UTF8_STRING",
+    "text/plain",
+    "STRING",
+    "TEXT",
+};
+
+static bool isText(const std::string &mimeType)
+{
+    for (const char *t: s_textMimeTypes) {
+        if (mimeType == t) {
+            return true;
+        }
+    }
+    return mimeType.compare(0, 5, "text/") == 0;
+}
+
+static int64_t elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct ClipboardHistory::Reference {
+    // null once the source is gone
+    weston_data_source *source;
+    Listener sourceListener;
+    std::string preview;
+};
+
+struct ClipboardHistory::Reader {
+    ~Reader()
+    {
+        wl_event_source_remove(eventSource);
+        close(fd);
+    }
+
+    bool read();
+
+    ClipboardHistory *history;
+    int fd;
+    wl_event_source *eventSource;
+    // null if the source went away while reading it
+    weston_data_source *source;
+    Listener sourceListener;
+    std::string mimeType;
+    std::string data;
+    uint64_t hash;
+    std::chrono::steady_clock::time_point start;
+};
+
+// returns false when there is nothing more to read for now, or when the reader is done
+bool ClipboardHistory::Reader::read()
+{
+    ssize_t len = ClipboardTransfer::readChunk(fd, &data, &hash);
+    if (len < 0 && errno == EAGAIN) {
+        return false;
+    }
+    if (len <= 0) {
+        history->readDone(this, len == 0);
+        return false;
+    }
+    // the rest of a big selection is left to its source, which sends it when it is pasted
+    if (data.size() > MaxEntrySize) {
+        history->readDone(this, true);
+        return false;
+    }
+    return true;
+}
+
+struct ClipboardHistory::Source {
+    weston_data_source base;
+    ClipboardHistory *history;
+    uint32_t id;
+
+    static void accept(weston_data_source *, uint32_t, const char *) {}
+    static void send(weston_data_source *base, const char *mimeType, int32_t fd)
+    {
+        Source *s = wl_container_of(base, (Source *)nullptr, base);
+        if (s->history) {
+            s->history->send(s->id, fd);
+        } else {
+            close(fd);
+        }
+    }
+    static void cancel(weston_data_source *base)
+    {
+        Source *s = wl_container_of(base, (Source *)nullptr, base);
+        if (s->history) {
+            auto &sources = s->history->m_sources;
+            auto it = std::find(sources.begin(), sources.end(), s);
+            if (it != sources.end()) {
+                sources.erase(it);
+            }
+        }
+        // weston is still using the source at this point, destroy it later
+        Timer::singleShot(0, [s]() {
+            wl_signal_emit(&s->base.destroy_signal, &s->base);
+            char **types = static_cast<char **>(s->base.mime_types.data);
+            for (size_t i = 0; i < s->base.mime_types.size / sizeof(char *); ++i) {
+                free(types[i]);
+            }
+            wl_array_release(&s->base.mime_types);
+            delete s;
+        });
+    }
+};
+
+ClipboardHistory::ClipboardHistory(Compositor *c)
+                : QObject()
+                , m_compositor(c)
+                , m_totalSize(0)
+                , m_nextId(1)
+                , m_current(0)
+{
+    for (Seat *s: c->seats()) {
+        connect(s, &Seat::selection, this, &ClipboardHistory::selection);
+    }
+    connect(c, &Compositor::seatCreated, this, [this](Seat *s) {
+        connect(s, &Seat::selection, this, &ClipboardHistory::selection);
+    });
+}
+
+ClipboardHistory::~ClipboardHistory()
+{
+    for (Source *s: m_sources) {
+        s->history = nullptr;
+    }
+}
+
+const ClipboardHistory::Entry *ClipboardHistory::entry(uint32_t id) const
+{
+    auto it = m_byId.find(id);
+    return it != m_byId.end() ? &*it->second : nullptr;
+}
+
+std::string ClipboardHistory::preview(const Entry &entry)
+{
+    if (!isText(entry.mimeType)) {
+        return std::string();
+    }
+
+    std::string text = entry.data ? entry.data->substr(0, PreviewSize + 1) : entry.reference->preview;
+
+    if (text.size() > PreviewSize) {
+        size_t size = PreviewSize;
+        // don't cut a UTF-8 sequence in half
+        while (size > 0 && (text[size] & 0xc0) == 0x80) {
+            --size;
+        }
+        text.resize(size);
+    }
+    return text;
+}
+
+void ClipboardHistory::selection(Seat *seat)
+{
+    weston_data_source *source = seat->westonSeat()->selection_data_source;
+    if (source && source->send == Source::send) {
+        Source *s = wl_container_of(source, (Source *)nullptr, base);
+        setCurrent(s->id);
+        return;
+    }
+
+    // until we have read it we don't know if it is already in the history
+    setCurrent(0);
+    if (!source) {
+        m_reader.reset();
+        return;
+    }
+
+    const char *mimeType = nullptr;
+    char **types = static_cast<char **>(source->mime_types.data);
+    size_t numTypes = source->mime_types.size / sizeof(char *);
+    for (const char *t: s_textMimeTypes) {
+        for (size_t i = 0; i < numTypes && !mimeType; ++i) {
+            if (strcmp(types[i], t) == 0) {
+                mimeType = types[i];
+            }
+        }
+    }
+    if (!mimeType && numTypes > 0) {
+        mimeType = types[0];
+    }
+    if (!mimeType) {
+        return;
+    }
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) == -1) {
+        return;
+    }
+
+    // a newer selection supersedes the one we were still reading, so apps changing the
+    // selection in a tight loop only cost us the last transfer
+    m_reader.reset(new Reader);
+    m_reader->history = this;
+    m_reader->fd = fds[0];
+    m_reader->source = source;
+    m_reader->mimeType = mimeType;
+    m_reader->hash = ClipboardTransfer::HashSeed;
+    m_reader->start = std::chrono::steady_clock::now();
+    m_reader->sourceListener.setNotify([](Listener *l, void *data) {
+        l->disconnect();
+        Reader *reader = wl_container_of(l, (Reader *)nullptr, sourceListener);
+        reader->source = nullptr;
+    });
+    m_reader->sourceListener.connect(&source->destroy_signal);
+    m_reader->eventSource = wl_event_loop_add_fd(wl_display_get_event_loop(m_compositor->display()), fds[0], WL_EVENT_READABLE,
+                                                 [](int fd, uint32_t mask, void *data) {
+        Reader *reader = static_cast<Reader *>(data);
+        // don't hog the event loop, do a few chunks and then let the loop call us again
+        for (int i = 0; i < 16; ++i) {
+            if (!reader->read()) {
+                break;
+            }
+        }
+        return 0;
+    }, m_reader.get());
+
+    // the source takes ownership of the write end
+    source->send(source, mimeType, fds[1]);
+}
+
+void ClipboardHistory::readDone(Reader *reader, bool ok)
+{
+    if (!ok || reader->data.empty()) {
+        m_reader.reset();
+        return;
+    }
+
+    Entry entry;
+    entry.id = 0;
+    entry.mimeType = reader->mimeType;
+    if (reader->data.size() > MaxEntrySize) {
+        if (!reader->source) {
+            m_reader.reset();
+            return;
+        }
+        Debug::debug("Selection of type '{}' is bigger than {} bytes, keeping only a reference to its source",
+                     reader->mimeType, MaxEntrySize);
+        auto reference = std::make_shared<Reference>();
+        reference->source = reader->source;
+        reference->preview = reader->data.substr(0, PreviewSize + 1);
+        entry.hash = 0;
+        entry.size = 0;
+        entry.reference = reference;
+    } else {
+        Debug::debug("Read {} bytes of type '{}' from the selection in {} ms", reader->data.size(), reader->mimeType,
+                     elapsed(reader->start));
+        entry.hash = ClipboardTransfer::hash(reader->hash, reader->mimeType.data(), reader->mimeType.size());
+        entry.size = reader->data.size();
+        entry.data = std::make_shared<const std::string>(std::move(reader->data));
+    }
+    m_reader.reset();
+    insert(std::move(entry));
+}
+
+void ClipboardHistory::insert(Entry &&entry)
+{
+    // the hash only narrows down the candidates, the data is what must match. The references
+    // are never the same as another entry, they come from a new source every time
+    auto range = entry.data ? m_byHash.equal_range(entry.hash) : std::make_pair(m_byHash.end(), m_byHash.end());
+    for (auto i = range.first; i != range.second; ++i) {
+        auto it = i->second;
+        if (it->mimeType == entry.mimeType && it->size == entry.size && *it->data == *entry.data) {
+            if (it != m_entries.begin()) {
+                m_entries.splice(m_entries.begin(), m_entries, it);
+                emit entryRemoved(it->id);
+                emit entryAdded(*it);
+            }
+            setCurrent(it->id);
+            return;
+        }
+    }
+
+    entry.id = m_nextId++;
+    m_entries.push_front(std::move(entry));
+    auto it = m_entries.begin();
+    m_byId[it->id] = it;
+    if (it->data) {
+        m_byHash.insert({ it->hash, it });
+        m_totalSize += it->size;
+    } else {
+        // the entry can't be pasted anymore without its source. The listener can't delete
+        // itself while it is being called, so remove the entry a bit later
+        uint32_t id = it->id;
+        Reference *reference = it->reference.get();
+        reference->sourceListener.setNotify([this, id, reference](Listener *l, void *) {
+            l->disconnect();
+            reference->source = nullptr;
+            Timer::singleShot(0, [this, id]() { remove(id); });
+        });
+        reference->sourceListener.connect(&reference->source->destroy_signal);
+    }
+    emit entryAdded(*it);
+    setCurrent(it->id);
+
+    while (m_entries.size() > 1 && (m_entries.size() > MaxEntries || m_totalSize > MaxTotalSize)) {
+        erase(std::prev(m_entries.end()));
+    }
+}
+
+void ClipboardHistory::erase(std::list<Entry>::iterator it)
+{
+    uint32_t id = it->id;
+    auto range = m_byHash.equal_range(it->hash);
+    for (auto i = range.first; i != range.second; ++i) {
+        if (i->second == it) {
+            m_byHash.erase(i);
+            break;
+        }
+    }
+    m_byId.erase(id);
+    if (it->data) {
+        m_totalSize -= it->size;
+    }
+    m_entries.erase(it);
+
+    emit entryRemoved(id);
+    if (m_current == id) {
+        setCurrent(0);
+    }
+}
+
+void ClipboardHistory::setCurrent(uint32_t id)
+{
+    if (m_current != id) {
+        m_current = id;
+        emit currentChanged(id);
+    }
+}
+
+void ClipboardHistory::remove(uint32_t id)
+{
+    auto it = m_byId.find(id);
+    if (it != m_byId.end()) {
+        erase(it->second);
+    }
+}
+
+void ClipboardHistory::activate(uint32_t id)
+{
+    const Entry *e = entry(id);
+    if (!e) {
+        return;
+    }
+
+    for (Seat *seat: m_compositor->seats()) {
+        // the source of a reference may still be the selection, leave it alone
+        if (e->reference && seat->westonSeat()->selection_data_source == e->reference->source) {
+            setCurrent(id);
+            continue;
+        }
+
+        Source *s = new Source;
+        memset(&s->base, 0, sizeof(s->base));
+        wl_signal_init(&s->base.destroy_signal);
+        wl_array_init(&s->base.mime_types);
+        s->base.accept = Source::accept;
+        s->base.send = Source::send;
+        s->base.cancel = Source::cancel;
+        s->history = this;
+        s->id = id;
+
+        auto addMimeType = [s](const char *type) {
+            char **p = static_cast<char **>(wl_array_add(&s->base.mime_types, sizeof(char *)));
+            *p = strdup(type);
+        };
+        if (isText(e->mimeType)) {
+            for (const char *t: s_textMimeTypes) {
+                addMimeType(t);
+            }
+        } else {
+            addMimeType(e->mimeType.c_str());
+        }
+
+        m_sources.push_back(s);
+        weston_seat_set_selection(seat->westonSeat(), &s->base, wl_display_next_serial(m_compositor->display()));
+    }
+}
+
+void ClipboardHistory::send(uint32_t id, int fd)
+{
+    const Entry *e = entry(id);
+    if (!e || (e->reference && !e->reference->source)) {
+        close(fd);
+        return;
+    }
+
+    if (e->reference) {
+        // let the source write to the client pasting, so the data doesn't go through us
+        weston_data_source *source = e->reference->source;
+        source->send(source, e->mimeType.c_str(), fd);
+        return;
+    }
+
+    // the entry may be evicted while the transfer is running, so keep a reference to its content
+    struct Writer {
+        int fd;
+        wl_event_source *source;
+        std::shared_ptr<const std::string> data;
+        size_t size;
+        off_t offset;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    Writer *writer = new Writer{ fd, nullptr, e->data, e->size, 0, std::chrono::steady_clock::now() };
+    writer->source = wl_event_loop_add_fd(wl_display_get_event_loop(m_compositor->display()), fd, WL_EVENT_WRITABLE,
+                                          [](int fd, uint32_t mask, void *data) {
+        Writer *writer = static_cast<Writer *>(data);
+        ssize_t len = write(fd, writer->data->data() + writer->offset, writer->size - writer->offset);
+        if (len > 0) {
+            writer->offset += len;
+        }
+        if (len < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return 0;
+        }
+        if (len <= 0 || (size_t)writer->offset == writer->size) {
+            Debug::debug("Sent {} of {} bytes of the selection in {} ms", writer->offset, writer->size, elapsed(writer->start));
+            wl_event_source_remove(writer->source);
+            close(fd);
+            delete writer;
+        }
+        return 0;
+    }, writer);
+}
+
+}
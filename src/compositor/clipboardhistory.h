@@ -0,0 +1,113 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_CLIPBOARDHISTORY_H
+#define ORBITAL_CLIPBOARDHISTORY_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <QObject>
+
+struct weston_data_source;
+
+namespace Orbital {
+
+class Compositor;
+class Seat;
+
+/**
+ * Keeps the recent selections, deduplicated by their content.
+ * Only one mime type per selection is stored, preferring text, and the memory
+ * used is capped in total, evicting the oldest entries first.
+ * A selection is only read up to MaxEntrySize when it is set. The bigger ones are
+ * not copied: their entry only keeps a reference to the source and a preview, and
+ * the source sends them straight to the client pasting them. Such an entry goes
+ * away together with its source.
+ */
+class ClipboardHistory : public QObject
+{
+    Q_OBJECT
+public:
+    struct Reference;
+    struct Entry {
+        uint32_t id;
+        size_t hash;
+        std::string mimeType;
+        // 0 for the references, their size is not known
+        size_t size;
+        // only one of these is set
+        std::shared_ptr<const std::string> data;
+        std::shared_ptr<Reference> reference;
+    };
+
+    static const size_t MaxEntrySize = 1 << 20;
+    static const size_t MaxTotalSize = 16 << 20;
+    static const size_t MaxEntries = 100;
+    static const size_t PreviewSize = 200;
+
+    explicit ClipboardHistory(Compositor *c);
+    ~ClipboardHistory();
+
+    const std::list<Entry> &entries() const { return m_entries; }
+    const Entry *entry(uint32_t id) const;
+    uint32_t current() const { return m_current; }
+
+    void activate(uint32_t id);
+    void remove(uint32_t id);
+    /**
+     * Write the content of the entry to the fd, asynchronously.
+     * Takes ownership of the fd.
+     */
+    void send(uint32_t id, int fd);
+
+    static std::string preview(const Entry &entry);
+
+signals:
+    void entryAdded(const ClipboardHistory::Entry &entry);
+    void entryRemoved(uint32_t id);
+    void currentChanged(uint32_t id);
+
+private:
+    struct Reader;
+    struct Source;
+
+    void selection(Seat *seat);
+    void readDone(Reader *reader, bool ok);
+    void insert(Entry &&entry);
+    void erase(std::list<Entry>::iterator it);
+    void setCurrent(uint32_t id);
+
+    Compositor *m_compositor;
+    std::list<Entry> m_entries;
+    std::unordered_map<uint32_t, std::list<Entry>::iterator> m_byId;
+    std::unordered_multimap<size_t, std::list<Entry>::iterator> m_byHash;
+    size_t m_totalSize;
+    uint32_t m_nextId;
+    uint32_t m_current;
+    std::unique_ptr<Reader> m_reader;
+    std::vector<Source *> m_sources;
+};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+
+#include "clipboardtransfer.h"
+
+namespace Orbital {
+
+namespace ClipboardTransfer {
+
+uint64_t hash(uint64_t hash, const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+ssize_t readChunk(int fd, std::string *data, uint64_t *h)
+{
+    size_t size = data->size();
+    data->resize(size + ChunkSize);
+    ssize_t len;
+    do {
+        len = read(fd, &(*data)[size], ChunkSize);
+    } while (len < 0 && errno == EINTR);
+    int error = errno;
+    data->resize(size + (len > 0 ? len : 0));
+    errno = error;
+
+    if (len > 0) {
+        *h = hash(*h, &(*data)[size], len);
+    }
+    return len;
+}
+
+}
+
+}
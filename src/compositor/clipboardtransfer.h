@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_CLIPBOARDTRANSFER_H
+#define ORBITAL_CLIPBOARDTRANSFER_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+
+namespace Orbital {
+
+/**
+ * The low level I/O used by the clipboard history to read the selections,
+ * kept apart from the history so that it can be benchmarked on its own.
+ */
+namespace ClipboardTransfer {
+
+static const size_t ChunkSize = 64 * 1024;
+
+// FNV-1a, so that it can be computed while the data streams in. It is not collision
+// resistant, it only narrows down the entries whose data must be compared.
+static const uint64_t HashSeed = 14695981039346656037ull;
+uint64_t hash(uint64_t hash, const char *data, size_t size);
+
+/**
+ * Appends at most ChunkSize bytes read from the fd to the data, updating the hash.
+ * Returns the number of bytes read, 0 at the end of the data, or -1 setting errno.
+ */
+ssize_t readChunk(int fd, std::string *data, uint64_t *hash);
+
+}
+
+}
+
+#endif
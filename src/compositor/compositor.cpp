@@ -49,6 +49,7 @@
 #include "fmt/format.h"
 #include "fmt/ostream.h"
 #include "debug.h"
+#include "westonprivate.h"
 
 namespace Orbital {
 
@@ -527,12 +528,6 @@ void Compositor::newOutput(weston_output *output)
     emit outputCreated(o);
 }
 
-//XXX FIXME This comes from compositor.c, it should not stay here!!
-struct weston_frame_callback {
-    struct wl_resource *resource;
-    struct wl_list link;
-};
-
 void Compositor::fakeRepaint()
 {
     wl_list frame_callback_list;
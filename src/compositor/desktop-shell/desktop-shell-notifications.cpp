@@ -35,6 +35,9 @@
 namespace Orbital {
 
 static const int ANIMATION_DURATION = 200;
+static const int MARGIN = 10;
+// how often the notifications that are not on any output get their frame callbacks
+static const int OFFSCREEN_FRAME_INTERVAL = 16;
 
 class DesktopShellNotifications::NotificationSurface : public QObject, public Surface::RoleHandler
 {
@@ -81,6 +84,7 @@ public:
         NotificationSurface *parent;
         Animation<double> alphaAnim;
         Animation<QPointF> moveAnim;
+        QPointF target;
     };
 
     NotificationSurface(Compositor *c, Surface *s)
@@ -89,12 +93,7 @@ public:
         , initialMove(false)
     {
         for (Output *o: c->outputs()) {
-            NSView *v = new NSView(o, this, s);
-            m_views.push_back(v);
-            v->setTransformParent(o->rootView());
-            v->alphaAnim.update.connect(v, &View::setAlpha);
-            v->moveAnim.update.connect(v, overload<const QPointF &>(&View::setPos));
-            c->layer(Compositor::Layer::Overlay)->addView(v);
+            addView(o);
         }
 
         s->setLabel("notification");
@@ -106,11 +105,26 @@ public:
     ~NotificationSurface()
     {
         manager->m_notifications.remove(this);
+        manager->scheduleRelayout();
     }
-    void moveTo(int x, int y)
+    NSView *addView(Output *o)
+    {
+        NSView *v = new NSView(o, this, m_surface);
+        m_views.push_back(v);
+        v->setTransformParent(o->rootView());
+        v->alphaAnim.update.connect(v, &View::setAlpha);
+        v->moveAnim.update.connect(v, overload<const QPointF &>(&View::setPos));
+        m_compositor->layer(Compositor::Layer::Overlay)->addView(v);
+        return v;
+    }
+    void moveTo(int y)
     {
         for (NSView *view: m_views) {
-            auto endPos = QPointF(x + view->output->width() - m_surface->width() - 20, y + 20);
+            auto endPos = QPointF(view->output->width() - m_surface->width() - 20, y + 20);
+            if (initialMove && view->target == endPos) {
+                continue;
+            }
+            view->target = endPos;
             if (initialMove) {
                 view->moveAnim.setStart(view->pos());
                 view->moveAnim.setTarget(endPos);
@@ -123,13 +137,9 @@ public:
     }
     void outputCreated(Output *o)
     {
-        NSView *v = new NSView(o, this, m_surface);
-        m_views.push_back(v);
-        v->setTransformParent(o->rootView());
-        v->alphaAnim.update.connect(v, &View::setAlpha);
-        v->moveAnim.update.connect(v, overload<const QPointF &>(&View::setPos));
-        m_compositor->layer(Compositor::Layer::Overlay)->addView(v);
-        manager->relayout();
+        NSView *v = addView(o);
+        v->target = QPointF(o->width() - m_surface->width() - 20, layoutY + 20);
+        v->setPos(v->target);
     }
     void outputRemoved(Output *o)
     {
@@ -144,18 +154,20 @@ public:
     {
         // All notifications (currently) come from the same client. If there are many
         // notifications so that one or more is pushed offscreen, its weston_surface::output_mask
-        // will be 0, being outside the output. That means trying to repaint the surface or
-        // the view will not really repaint it, so the frame callbacks for that surface will
-        // not be sent, blocking the client.
-        // To solve it manually redraw all the outputs, this way we're sure the surface gets
-        // repainted and the frame callbacks sent.
-        for (Output *o: m_compositor->outputs()) {
-            o->repaint();
+        // will be 0, being outside the output. That means the surface will never be repainted,
+        // so the frame callbacks for that surface will not be sent, blocking the client.
+        // Send them ourselves for those surfaces, the visible ones are repainted by weston
+        // as usual.
+        if (m_surface->surface()->output_mask == 0) {
+            manager->scheduleOffscreenFrame();
         }
+
         if (std::find(manager->m_notifications.begin(), manager->m_notifications.end(), this) ==
             manager->m_notifications.end()) {
             manager->m_notifications.push_front(this);
-            manager->relayout();
+            manager->scheduleRelayout();
+        } else if (m_surface->height() != layoutHeight || m_surface->width() != layoutWidth) {
+            manager->scheduleRelayout();
         }
     }
 
@@ -165,6 +177,9 @@ public:
     std::vector<NSView *> m_views;
     bool inactive;
     bool initialMove;
+    int layoutY = 0;
+    int layoutWidth = 0;
+    int layoutHeight = 0;
     DesktopShellNotifications *manager;
 };
 
@@ -173,8 +188,13 @@ DesktopShellNotifications::DesktopShellNotifications(Shell *shell)
                   : Interface(shell)
                   , Global(shell->compositor(), &notifications_manager_interface, 1)
                   , m_shell(shell)
+                  , m_relayoutPending(false)
+                  , m_framePending(false)
 {
-
+    m_relayoutTimer.setRepeat(false);
+    m_relayoutTimer.setTimeoutHandler([this]() { relayout(); });
+    m_frameTimer.setRepeat(false);
+    m_frameTimer.setTimeoutHandler([this]() { sendOffscreenFrames(); });
 }
 
 DesktopShellNotifications::~DesktopShellNotifications()
@@ -208,14 +228,45 @@ void DesktopShellNotifications::pushNotification(wl_client *, wl_resource *res,
     surf->manager = this;
 }
 
+void DesktopShellNotifications::scheduleRelayout()
+{
+    // many notifications may come or go at the same time, lay them out only once
+    // when that is done
+    if (!m_relayoutPending) {
+        m_relayoutPending = true;
+        m_relayoutTimer.start(0);
+    }
+}
+
 void DesktopShellNotifications::relayout()
 {
-    int x = 0;
+    m_relayoutPending = false;
+
     int y = 0;
-    int margin = 10;
     for (NotificationSurface *notification: m_notifications) {
-        notification->moveTo(x, y);
-        y += notification->m_surface->height() + margin;
+        notification->layoutY = y;
+        notification->layoutWidth = notification->m_surface->width();
+        notification->layoutHeight = notification->m_surface->height();
+        notification->moveTo(y);
+        y += notification->layoutHeight + MARGIN;
+    }
+}
+
+void DesktopShellNotifications::scheduleOffscreenFrame()
+{
+    if (!m_framePending) {
+        m_framePending = true;
+        m_frameTimer.start(OFFSCREEN_FRAME_INTERVAL);
+    }
+}
+
+void DesktopShellNotifications::sendOffscreenFrames()
+{
+    m_framePending = false;
+    for (NotificationSurface *notification: m_notifications) {
+        if (notification->m_surface->surface()->output_mask == 0) {
+            notification->m_surface->sendFrameCallbacks();
+        }
     }
 }
 
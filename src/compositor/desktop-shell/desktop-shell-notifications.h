@@ -24,6 +24,7 @@
 #include <list>
 
 #include "../interface.h"
+#include "../timer.h"
 
 namespace Orbital {
 
@@ -42,10 +43,17 @@ protected:
 private:
     class NotificationSurface;
     void pushNotification(wl_client *, wl_resource *res, uint32_t id, wl_resource *surfaceResource, int32_t flags);
+    void scheduleRelayout();
     void relayout();
+    void scheduleOffscreenFrame();
+    void sendOffscreenFrames();
 
     Shell *m_shell;
     std::list<NotificationSurface *> m_notifications;
+    Timer m_relayoutTimer;
+    Timer m_frameTimer;
+    bool m_relayoutPending;
+    bool m_framePending;
 };
 
 }
@@ -37,6 +37,7 @@
 #include "../fmt/format.h"
 #include "../fmt/ostream.h"
 #include "../surface.h"
+#include "../thumbnail.h"
 #include "desktopfile.h"
 
 #include "wayland-desktop-shell-server-protocol.h"
@@ -133,9 +134,12 @@ void DesktopShellWindow::create()
         wrapInterface(close),
         wrapInterface(preview),
         wrapInterface(endPreview),
+        wrapInterface(getThumbnail),
     };
 
-    m_resource = wl_resource_create(m_desktopShell->client(), &desktop_shell_window_interface, 1, 0);
+    // the windows have the version of the shell, a shell bound at version 1 cannot ask for thumbnails
+    int version = wl_resource_get_version(m_desktopShell->resource());
+    m_resource = wl_resource_create(m_desktopShell->client(), &desktop_shell_window_interface, version, 0);
     wl_resource_set_implementation(m_resource, &implementation, this, [](wl_resource *res) {
         DesktopShellWindow *win = static_cast<DesktopShellWindow *>(wl_resource_get_user_data(res));
         win->m_resource = nullptr;
@@ -247,4 +251,122 @@ void DesktopShellWindow::endPreview(wl_resource *output)
     shsurf()->endPreview(Output::fromResource(output));
 }
 
+void DesktopShellWindow::getThumbnail(wl_client *client, wl_resource *resource, uint32_t id, int32_t maxWidth, int32_t maxHeight)
+{
+    class ThumbnailResource : public QObject
+    {
+    public:
+        ThumbnailResource(Thumbnail *t, wl_resource *res, const QSize &max)
+            : thumbnail(t)
+            , resource(res)
+            , maxSize(max.expandedTo(QSize(1, 1)))
+            , buffer(nullptr)
+        {
+            static const struct desktop_shell_window_thumbnail_interface implementation = {
+                [](wl_client *, wl_resource *r) { wl_resource_destroy(r); },
+                wrapInterface(attach),
+            };
+            wl_resource_set_implementation(resource, &implementation, this, [](wl_resource *r) {
+                delete static_cast<ThumbnailResource *>(wl_resource_get_user_data(r));
+            });
+
+            bufferListener.parent = this;
+            bufferListener.listener.notify = [](wl_listener *l, void *) {
+                BufferListener *listener = wl_container_of(l, (BufferListener *)nullptr, listener);
+                listener->parent->setBuffer(nullptr);
+            };
+            wl_list_init(&bufferListener.listener.link);
+
+            connect(thumbnail, &Thumbnail::updated, this, &ThumbnailResource::fill);
+            connect(thumbnail, &QObject::destroyed, this, [this]() { thumbnail = nullptr; });
+            thumbnail->ref();
+            if (thumbnail->isValid()) {
+                configure();
+            }
+        }
+        ~ThumbnailResource()
+        {
+            setBuffer(nullptr);
+            if (thumbnail) {
+                thumbnail->deref();
+            }
+        }
+
+        void setBuffer(wl_resource *b)
+        {
+            wl_list_remove(&bufferListener.listener.link);
+            wl_list_init(&bufferListener.listener.link);
+            buffer = b;
+            if (buffer) {
+                wl_resource_add_destroy_listener(buffer, &bufferListener.listener);
+            }
+        }
+
+        void attach(wl_resource *b)
+        {
+            setBuffer(b);
+            if (thumbnail && thumbnail->isValid()) {
+                fill();
+            }
+        }
+
+        bool configure()
+        {
+            QSize s = thumbnail->size();
+            if (s.width() > maxSize.width() || s.height() > maxSize.height()) {
+                s.scale(maxSize, Qt::KeepAspectRatio);
+            }
+            s = s.expandedTo(QSize(1, 1));
+            if (s == size) {
+                return false;
+            }
+
+            size = s;
+            desktop_shell_window_thumbnail_send_configure(resource, size.width(), size.height());
+            return true;
+        }
+
+        void fill()
+        {
+            // a buffer of the old size is useless, the client will attach a new one after the configure
+            if (configure()) {
+                setBuffer(nullptr);
+                return;
+            }
+            if (!buffer) {
+                return;
+            }
+
+            wl_shm_buffer *shm = wl_shm_buffer_get(buffer);
+            if (!shm || wl_shm_buffer_get_width(shm) != size.width() || wl_shm_buffer_get_height(shm) != size.height() ||
+                wl_shm_buffer_get_format(shm) != WL_SHM_FORMAT_ARGB8888) {
+                setBuffer(nullptr);
+                return;
+            }
+
+            wl_shm_buffer_begin_access(shm);
+            thumbnail->copy(wl_shm_buffer_get_data(shm), size, wl_shm_buffer_get_stride(shm));
+            wl_shm_buffer_end_access(shm);
+
+            setBuffer(nullptr);
+            desktop_shell_window_thumbnail_send_updated(resource);
+        }
+
+        struct BufferListener {
+            wl_listener listener;
+            ThumbnailResource *parent;
+        };
+
+        Thumbnail *thumbnail;
+        wl_resource *resource;
+        QSize maxSize;
+        QSize size;
+        wl_resource *buffer;
+        BufferListener bufferListener;
+    };
+
+    wl_resource *res = wl_resource_create(client, &desktop_shell_window_thumbnail_interface, wl_resource_get_version(resource), id);
+    new ThumbnailResource(Thumbnail::get(shsurf()), res, QSize(maxWidth, maxHeight));
+}
+
 }
@@ -57,6 +57,7 @@ private:
     void close(wl_client *client, wl_resource *resource);
     void preview(wl_resource *output);
     void endPreview(wl_resource *output);
+    void getThumbnail(wl_client *client, wl_resource *resource, uint32_t id, int32_t maxWidth, int32_t maxHeight);
 
     DesktopShell *m_desktopShell;
     wl_resource *m_resource;
@@ -18,8 +18,12 @@
  */
 
 #include <linux/input.h>
+#include <string.h>
+
+#include <list>
 
 #include <QDebug>
+#include <QElapsedTimer>
 
 #include <wayland-server.h>
 
@@ -35,6 +39,10 @@
 #include "../global.h"
 #include "../layer.h"
 #include "../shellsurface.h"
+#include "../surface.h"
+#include "../timer.h"
+#include "../debug.h"
+#include "../xwayland.h"
 #include "../pager.h"
 #include "../dummysurface.h"
 #include "../focusscope.h"
@@ -51,7 +59,7 @@ namespace Orbital {
 
 DesktopShell::DesktopShell(Shell *shell)
             : Interface(shell)
-            , Global(shell->compositor(), &desktop_shell_interface, 1)
+            , Global(shell->compositor(), &desktop_shell_interface, 3)
             , m_shell(shell)
             , m_resource(nullptr)
             , m_grabView(nullptr)
@@ -126,7 +134,9 @@ void DesktopShell::bind(wl_client *client, uint32_t version, uint32_t id)
         wrapInterface(pong),
         wrapInterface(outputLoaded),
         wrapInterface(createActiveRegion),
-        wrapInterface(outputBound)
+        wrapInterface(outputBound),
+        wrapInterface(endSession),
+        wrapInterface(getElementSubsurface)
     };
 
     wl_resource_set_implementation(resource, &implementation, this, [](wl_resource *res) {
@@ -644,6 +654,100 @@ void DesktopShell::quit()
     m_shell->compositor()->quit();
 }
 
+void DesktopShell::endSession(uint32_t id, uint32_t timeout)
+{
+    // waits for the clients to go away, deleting itself when done
+    class SessionEnd
+    {
+    public:
+        SessionEnd(wl_resource *cb)
+            : callback(cb)
+        {
+            wl_resource_set_implementation(callback, nullptr, this, [](wl_resource *res) {
+                static_cast<SessionEnd *>(wl_resource_get_user_data(res))->callback = nullptr;
+            });
+            elapsed.start();
+        }
+
+        void clientGone()
+        {
+            if (--remaining == 0) {
+                done();
+            }
+        }
+
+        void done()
+        {
+            if (finished) {
+                return;
+            }
+            finished = true;
+
+            if (remaining > 0) {
+                Debug::debug("Session end: {} clients still running after {} ms, giving up on them", remaining, elapsed.elapsed());
+            } else {
+                Debug::debug("Session end: all clients exited after {} ms", elapsed.elapsed());
+            }
+            if (callback) {
+                wl_callback_send_done(callback, 0);
+                wl_resource_destroy(callback);
+            }
+            // this may be called by the timer or by a listener, delete it later
+            Timer::singleShot(0, [this]() { delete this; });
+        }
+
+        wl_resource *callback;
+        std::list<Listener> listeners;
+        Timer timer;
+        QElapsedTimer elapsed;
+        size_t remaining = 0;
+        bool finished = false;
+    };
+
+    wl_resource *callback = wl_resource_create(m_client->client(), &wl_callback_interface, 1, id);
+    SessionEnd *end = new SessionEnd(callback);
+
+    // Xwayland is a single client for all the X windows and it would not go away by itself,
+    // so the X windows are asked to close through the window manager but not waited for,
+    // Xwayland is left to be taken down when the compositor quits
+    XWayland *xwayland = m_shell->findInterface<XWayland>();
+    wl_client *xclient = xwayland ? xwayland->client() : nullptr;
+
+    std::unordered_map<wl_client *, std::vector<ShellSurface *>> clients;
+    for (ShellSurface *shsurf: m_shell->surfaces()) {
+        wl_client *client = shsurf->surface()->client();
+        if (xclient && client == xclient) {
+            shsurf->requestClose();
+        } else if (client != m_client->client()) {
+            clients[client].push_back(shsurf);
+        }
+    }
+
+    for (auto &c: clients) {
+        end->listeners.emplace_back();
+        Listener &listener = end->listeners.back();
+        listener.setNotify([end](Listener *l, void *) {
+            // old libwayland versions leave the listener in the list of the freed client
+            l->disconnect();
+            end->clientGone();
+        });
+        listener.connect(c.first);
+        ++end->remaining;
+        for (ShellSurface *shsurf: c.second) {
+            shsurf->close();
+        }
+    }
+
+    Debug::debug("Session end: asked {} clients to quit", end->remaining);
+    if (end->remaining == 0) {
+        end->done();
+        return;
+    }
+    end->timer.setRepeat(false);
+    end->timer.setTimeoutHandler([end]() { end->done(); });
+    end->timer.start(timeout);
+}
+
 void DesktopShell::pong(uint32_t serial)
 {
 }
@@ -703,6 +807,67 @@ void DesktopShell::createActiveRegion(uint32_t id, wl_resource *parentResource,
     new ActiveRegion(m_shell->compositor(), res, Surface::fromResource(parentResource), x, y, width, height);
 }
 
+void DesktopShell::getElementSubsurface(uint32_t id, wl_resource *surfaceResource, wl_resource *outputResource)
+{
+    Surface *surface = Surface::fromResource(surfaceResource);
+    const char *role = surface->role();
+    if (!role || strcmp(role, "wl_subsurface") != 0) {
+        wl_resource_post_error(m_resource, DESKTOP_SHELL_ERROR_ROLE, "the element surface is not a subsurface");
+        return;
+    }
+
+    class ElementSubsurface : public QObject
+    {
+    public:
+        ElementSubsurface(wl_resource *res, Surface *s, Output *o)
+            : resource(res)
+            , surface(s)
+            , output(o)
+        {
+            // the subsurface may go away before the resource
+            connect(s, &QObject::destroyed, this, [this]() {
+                updateExclusiveRect(QRect());
+                surface = nullptr;
+            });
+        }
+        ~ElementSubsurface()
+        {
+            updateExclusiveRect(QRect());
+        }
+        void destroy(wl_client *c, wl_resource *r)
+        {
+            wl_resource_destroy(r);
+        }
+        void setExclusiveRect(wl_client *c, wl_resource *r, int32_t x, int32_t y, int32_t w, int32_t h)
+        {
+            updateExclusiveRect(QRect(x, y, w, h));
+        }
+        void updateExclusiveRect(const QRect &rect)
+        {
+            if (surface && output && (!rect.isEmpty() || !exclusiveRect.isEmpty())) {
+                output->setExclusiveArea(surface, rect);
+            }
+            exclusiveRect = rect;
+        }
+
+        wl_resource *resource;
+        Surface *surface;
+        QPointer<Output> output;
+        QRect exclusiveRect;
+    };
+
+    static const struct desktop_shell_element_subsurface_interface implementation = {
+        wrapExtInterface(&ElementSubsurface::destroy),
+        wrapExtInterface(&ElementSubsurface::setExclusiveRect)
+    };
+
+    wl_resource *res = wl_resource_create(m_client->client(), &desktop_shell_element_subsurface_interface, 1, id);
+    ElementSubsurface *subsurface = new ElementSubsurface(res, surface, Output::fromResource(outputResource));
+    wl_resource_set_implementation(res, &implementation, subsurface, [](wl_resource *r) {
+        delete static_cast<ElementSubsurface *>(wl_resource_get_user_data(r));
+    });
+}
+
 void DesktopShell::sendNewAction(StringView name, Shell::Action *action)
 {
     if (!m_resource) {
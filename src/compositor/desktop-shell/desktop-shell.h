@@ -84,6 +84,8 @@ private:
     void outputLoaded(uint32_t serial);
     void createActiveRegion(uint32_t id, wl_resource *parentResource, int32_t x, int32_t y, int32_t width, int32_t height);
     void outputBound(uint32_t id, wl_resource *output);
+    void endSession(uint32_t id, uint32_t timeout);
+    void getElementSubsurface(uint32_t id, wl_resource *surfaceResource, wl_resource *outputResource);
     void sendNewAction(StringView name, Shell::Action *action);
 
     Shell *m_shell;
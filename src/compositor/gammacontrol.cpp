@@ -17,19 +17,133 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
 #include <QDebug>
+#include <QPointer>
+#include <QElapsedTimer>
 
 #include "gammacontrol.h"
 #include "shell.h"
 #include "utils.h"
 #include "output.h"
+#include "timer.h"
 #include "wayland-gammacontrol-server-protocol.h"
 
 namespace Orbital {
 
+/*
+ * The gamma state of an output. It remembers the ramp last written to the hardware,
+ * so that transitions start from what is on screen and writes that wouldn't change
+ * anything are skipped. It is a child of the output, so it goes away together with it.
+ * The transitions don't run on the repaint loop, the gamma doesn't need a repaint.
+ * They are stepped by a timer, only as often as the ramps can change by one unit.
+ */
+class GammaControlManager::OutputGamma : public QObject
+{
+public:
+    OutputGamma(Output *o)
+        : QObject(o)
+        , output(o)
+        , size(o->gammaSize())
+    {
+        // weston doesn't tell us the ramp that was set before we started, assume it
+        // was the identity one
+        original.resize(size * 3);
+        for (size_t i = 0; i < size; ++i) {
+            uint16_t v = size > 1 ? i * 0xffff / (size - 1) : 0xffff;
+            original[i] = original[i + size] = original[i + 2 * size] = v;
+        }
+        // nothing was written yet, so that the first write always goes to the hardware
+        // even if it is the ramp we assume is there
+
+        timer.setTimeoutHandler([this]() { step(); });
+    }
+
+    void set(const uint16_t *r, const uint16_t *g, const uint16_t *b)
+    {
+        timer.stop();
+        fill(target, r, g, b);
+        write(target);
+    }
+    void animate(const uint16_t *r, const uint16_t *g, const uint16_t *b, uint32_t duration)
+    {
+        timer.stop();
+        start = current.empty() ? original : current;
+        fill(target, r, g, b);
+
+        // there is no point in stepping more often than the biggest ramp value changes by one
+        int delta = 0;
+        for (size_t i = 0; i < target.size(); ++i) {
+            delta = std::max(delta, abs((int)target[i] - (int)start[i]));
+        }
+        if (delta == 0 || duration == 0) {
+            write(target);
+            return;
+        }
+
+        this->duration = duration;
+        elapsed.start();
+        timer.start(std::max<int64_t>(MinStepInterval, duration / delta));
+    }
+    void reset()
+    {
+        timer.stop();
+        write(original);
+    }
+
+    Output *output;
+    size_t size;
+    std::vector<uint16_t> original;
+    std::vector<uint16_t> current;
+
+private:
+    void fill(std::vector<uint16_t> &ramp, const uint16_t *r, const uint16_t *g, const uint16_t *b)
+    {
+        ramp.resize(size * 3);
+        memcpy(ramp.data(), r, size * sizeof(uint16_t));
+        memcpy(ramp.data() + size, g, size * sizeof(uint16_t));
+        memcpy(ramp.data() + 2 * size, b, size * sizeof(uint16_t));
+    }
+    void step()
+    {
+        double v = std::min(1., (double)elapsed.elapsed() / duration);
+        if (v >= 1.) {
+            timer.stop();
+        }
+
+        frame.resize(size * 3);
+        for (size_t i = 0; i < frame.size(); ++i) {
+            frame[i] = start[i] + ((int)target[i] - (int)start[i]) * v + 0.5;
+        }
+        write(frame);
+    }
+    void write(const std::vector<uint16_t> &ramp)
+    {
+        // each write is an ioctl to the kernel, only do it when something changed
+        if (ramp == current) {
+            return;
+        }
+        current = ramp;
+        output->setGamma(size, current.data(), current.data() + size, current.data() + 2 * size);
+    }
+
+    std::vector<uint16_t> start;
+    std::vector<uint16_t> target;
+    std::vector<uint16_t> frame;
+    // about one frame at 60Hz, faster steps could not be seen anyway
+    static const int MinStepInterval = 16;
+    Timer timer;
+    QElapsedTimer elapsed;
+    uint32_t duration;
+};
+
 GammaControlManager::GammaControlManager(Shell *shell)
                    : Interface(shell)
-                   , RestrictedGlobal(shell->compositor(), &gamma_control_manager_interface, 1)
+                   , RestrictedGlobal(shell->compositor(), &gamma_control_manager_interface, 2)
 {
 
 }
@@ -54,6 +168,19 @@ void GammaControlManager::destroy(wl_client *client, wl_resource *res)
     wl_resource_destroy(res);
 }
 
+GammaControlManager::OutputGamma *GammaControlManager::outputGamma(Output *output)
+{
+    auto it = m_outputs.find(output);
+    if (it != m_outputs.end()) {
+        return it->second;
+    }
+
+    OutputGamma *gamma = new OutputGamma(output);
+    m_outputs[output] = gamma;
+    connect(gamma, &QObject::destroyed, this, [this, output]() { m_outputs.erase(output); });
+    return gamma;
+}
+
 void GammaControlManager::getGammaControl(wl_client *client, wl_resource *res, uint32_t id, wl_resource *outputRes)
 {
     Output *output = Output::fromResource(outputRes);
@@ -61,40 +188,55 @@ void GammaControlManager::getGammaControl(wl_client *client, wl_resource *res, u
     class GammaControl
     {
     public:
-        GammaControl(Output *o)
-            : output(o)
+        GammaControl(OutputGamma *g)
+            : gamma(g)
         {
         }
         void destroy(wl_client *c, wl_resource *r)
         {
             wl_resource_destroy(r);
         }
-        void setGamma(wl_client *c, wl_resource *res, wl_array *red, wl_array *green, wl_array *blue)
+        bool checkRamps(wl_resource *res, wl_array *red, wl_array *green, wl_array *blue)
         {
             if (red->size != green->size || red->size != blue->size) {
                 wl_resource_post_error(res, GAMMA_CONTROL_ERROR_INVALID_GAMMA, "The gamma ramps don't have the same size");
-                return;
+                return false;
+            }
+            if (red->size != gamma->size * sizeof(uint16_t)) {
+                wl_resource_post_error(res, GAMMA_CONTROL_ERROR_INVALID_GAMMA, "The gamma ramps don't match the gamma size");
+                return false;
+            }
+            return true;
+        }
+        void setGamma(wl_client *c, wl_resource *res, wl_array *red, wl_array *green, wl_array *blue)
+        {
+            if (gamma && checkRamps(res, red, green, blue)) {
+                gamma->set((uint16_t *)red->data, (uint16_t *)green->data, (uint16_t *)blue->data);
             }
-
-            uint16_t *r = (uint16_t *)red->data;
-            uint16_t *g = (uint16_t *)green->data;
-            uint16_t *b = (uint16_t *)blue->data;
-            output->setGamma(red->size / sizeof(uint16_t), r, g, b);
         }
         void resetGamma(wl_client *c, wl_resource *res)
         {
-
+            if (gamma) {
+                gamma->reset();
+            }
+        }
+        void setGammaAnimated(wl_client *c, wl_resource *res, wl_array *red, wl_array *green, wl_array *blue, uint32_t duration)
+        {
+            if (gamma && checkRamps(res, red, green, blue)) {
+                gamma->animate((uint16_t *)red->data, (uint16_t *)green->data, (uint16_t *)blue->data, duration);
+            }
         }
 
-        Output *output;
+        QPointer<OutputGamma> gamma;
     };
 
     static const struct gamma_control_interface implementation = {
         wrapExtInterface(&GammaControl::destroy),
         wrapExtInterface(&GammaControl::setGamma),
-        wrapExtInterface(&GammaControl::resetGamma)
+        wrapExtInterface(&GammaControl::resetGamma),
+        wrapExtInterface(&GammaControl::setGammaAnimated)
     };
-    GammaControl *gc = new GammaControl(output);
+    GammaControl *gc = new GammaControl(outputGamma(output));
 
     wl_resource *resource = wl_resource_create(client, &gamma_control_interface, wl_resource_get_version(res), id);
     wl_resource_set_implementation(resource, &implementation, gc, [](wl_resource *r) {
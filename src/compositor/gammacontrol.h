@@ -20,6 +20,8 @@
 #ifndef ORBITAL_GAMMACONTROL_H
 #define ORBITAL_GAMMACONTROL_H
 
+#include <unordered_map>
+
 #include "interface.h"
 
 struct wl_resource;
@@ -28,6 +30,7 @@ namespace Orbital {
 
 class Shell;
 class Seat;
+class Output;
 
 class GammaControlManager : public Interface, public RestrictedGlobal
 {
@@ -39,6 +42,11 @@ private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
     void destroy(wl_client *client, wl_resource *resource);
     void getGammaControl(wl_client *client, wl_resource *res, uint32_t id, wl_resource *outputRes);
+
+    class OutputGamma;
+    OutputGamma *outputGamma(Output *output);
+
+    std::unordered_map<Output *, OutputGamma *> m_outputs;
 };
 
 }
@@ -19,6 +19,7 @@
 
 #include <sys/mman.h>
 #include <sched.h>
+#include <signal.h>
 
 #include <QCoreApplication>
 #include <QCommandLineParser>
@@ -46,6 +47,9 @@ int main(int argc, char **argv)
         fmt::print(stderr, "Could not change the process scheduler: {}.\n", strerror(errno));
     }
 
+    // clients going away while we write the clipboard content to them must not kill us
+    signal(SIGPIPE, SIG_IGN);
+
     setenv("QT_MESSAGE_PATTERN", "[%{if-debug}D%{endif}%{if-warning}W%{endif}%{if-critical}C%{endif}%{if-fatal}F%{endif} %{appname}"
                                  " - %{file}:%{line}] == %{message}", 0);
 
@@ -17,6 +17,8 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include <QDebug>
 
 #include <compositor.h>
@@ -81,6 +83,7 @@ Output::Output(weston_output *out)
       , m_lockBackgroundSurface(new LockSurface(m_compositor, out->width, out->height))
       , m_lockSurfaceView(nullptr)
       , m_locked(false)
+      , m_lockFrame(LockFrame::None)
 {
     weston_output_init_zoom(m_output);
     m_transformRoot->view->setPos(out->x, out->y);
@@ -98,6 +101,7 @@ Output::Output(weston_output *out)
             cb();
         }
         o->m_callbacks.clear();
+        o->frameDone();
     };
     wl_signal_add(&out->frame_signal, &m_listener->frameListener);
 
@@ -251,6 +255,19 @@ void Output::setOverlay(Surface *surface)
     m_overlays.push_back(s->view);
 }
 
+void Output::setExclusiveArea(Surface *subsurface, const QRect &rect)
+{
+    auto it = std::find_if(m_exclusiveAreas.begin(), m_exclusiveAreas.end(),
+                           [subsurface](const std::pair<Surface *, QRect> &a) { return a.first == subsurface; });
+    if (it != m_exclusiveAreas.end()) {
+        m_exclusiveAreas.erase(it);
+    }
+    if (!rect.isEmpty()) {
+        m_exclusiveAreas.push_back(std::make_pair(subsurface, rect));
+    }
+    emit availableGeometryChanged();
+}
+
 void Output::setLockSurface(Surface *surface)
 {
     delete m_lockSurfaceView;
@@ -267,16 +284,22 @@ Surface *Output::lockSurface() const
     return m_lockSurfaceView ? m_lockSurfaceView->surface() : nullptr;
 }
 
-void Output::lock(const std::function<void ()> &done)
+void Output::lock(const std::function<void (uint32_t)> &presented)
 {
     m_locked = true;
     m_lockLayer->setParent(m_compositor->layer(Compositor::Layer::Lock));
-    repaint(done);
+    if (presented) {
+        m_lockCallbacks.push_back(presented);
+    }
+    m_lockFrame = LockFrame::Pending;
+    weston_output_schedule_repaint(m_output);
 }
 
 void Output::unlock()
 {
     m_locked = false;
+    m_lockFrame = LockFrame::None;
+    m_lockCallbacks.clear();
     m_lockBackgroundSurface->view->damageBelow();
     m_lockLayer->setParent(m_compositor->layer(Compositor::Layer::Minimized));
     repaint();
@@ -290,6 +313,31 @@ void Output::repaint(const std::function<void ()> &done)
     }
 }
 
+// The frame signal is emitted when a frame was submitted, not when it is shown, but weston
+// doesn't start a new repaint before the previous frame was presented. So the repaint after
+// the first one containing the lock layer means the lock is on screen, and by then frame_time
+// holds the presentation time of the lock frame.
+void Output::frameDone()
+{
+    switch (m_lockFrame) {
+        case LockFrame::None:
+            break;
+        case LockFrame::Pending:
+            m_lockFrame = LockFrame::Submitted;
+            weston_output_schedule_repaint(m_output);
+            break;
+        case LockFrame::Submitted: {
+            m_lockFrame = LockFrame::None;
+            auto callbacks = std::move(m_lockCallbacks);
+            m_lockCallbacks.clear();
+            for (auto &cb: callbacks) {
+                cb(m_output->frame_time);
+            }
+            break;
+        }
+    }
+}
+
 void Output::setPos(int x, int y)
 {
     weston_output_move(m_output, x, y);
@@ -339,6 +387,23 @@ QRect Output::availableGeometry() const
         pixman_region32_subtract(&area, &area, &surf);
         pixman_region32_fini(&surf);
     }
+    // the subsurfaces have no view of ours, use the one weston made on this output
+    for (const auto &a: m_exclusiveAreas) {
+        weston_view *view;
+        wl_list_for_each(view, &a.first->surface()->views, surface_link) {
+            if (view->output != m_output) {
+                continue;
+            }
+            float x, y;
+            weston_view_to_global_float(view, 0, 0, &x, &y);
+            QRect r = a.second.translated(x - m_output->x, y - m_output->y);
+            pixman_region32_t surf;
+            pixman_region32_init_rect(&surf, r.x(), r.y(), r.width(), r.height());
+            pixman_region32_subtract(&area, &area, &surf);
+            pixman_region32_fini(&surf);
+            break;
+        }
+    }
     pixman_box32_t *box = pixman_region32_extents(&area);
     pixman_region32_fini(&area);
     return QRect(box->x1, box->y1, box->x2 - box->x1, box->y2 - box->y1);
@@ -57,8 +57,17 @@ public:
     void setOverlay(Surface *surface);
     void setLockSurface(Surface *surface);
     Surface *lockSurface() const;
-
-    void lock(const std::function<void ()> &done);
+    /**
+     * Take the rect, in the coordinates of the subsurface, away from the available
+     * geometry. An empty rect removes the area of the subsurface.
+     */
+    void setExclusiveArea(Surface *subsurface, const QRect &rect);
+
+    /**
+     * Show the lock layer, calling presented with the presentation time in milliseconds
+     * once a frame containing it reached the screen.
+     */
+    void lock(const std::function<void (uint32_t)> &presented);
     void unlock();
 
     void repaint(const std::function<void ()> &done = nullptr);
@@ -90,7 +99,14 @@ signals:
     void pointerLeave(Pointer *pointer);
 
 private:
+    enum class LockFrame {
+        None,
+        Pending,
+        Submitted
+    };
+
     void onMoved();
+    void frameDone();
 
     Compositor *m_compositor;
     weston_output *m_output;
@@ -101,12 +117,15 @@ private:
     View *m_background;
     std::vector<View *> m_panels;
     std::vector<View *> m_overlays;
+    std::vector<std::pair<Surface *, QRect>> m_exclusiveAreas;
     Workspace *m_currentWs;
     Surface *m_backgroundSurface;
     LockSurface *m_lockBackgroundSurface;
     View *m_lockSurfaceView;
     bool m_locked;
     std::vector<std::function<void ()>> m_callbacks;
+    LockFrame m_lockFrame;
+    std::vector<std::function<void (uint32_t)>> m_lockCallbacks;
 
     friend View;
     friend BaseAnimation;
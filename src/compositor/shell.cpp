@@ -22,11 +22,14 @@
 #include <linux/input.h>
 #include <sys/resource.h>
 
+#include <algorithm>
+
 #include <QDebug>
 #include <QDir>
 #include <QProcess>
 #include <QSettings>
 
+#include <compositor.h>
 #include <libweston-desktop.h>
 
 #include "shell.h"
@@ -57,6 +60,7 @@
 #include "fmt/format.h"
 #include "fmt/ostream.h"
 #include "surface.h"
+#include "debug.h"
 #include "desktopfile.h"
 
 namespace Orbital {
@@ -68,6 +72,10 @@ Shell::Shell(Compositor *c)
      , m_grabCursorUnsetter(nullptr)
      , m_pager(new Pager(c))
      , m_locked(false)
+     , m_locking(false)
+     , m_lockStart(0)
+     , m_lockTime(0)
+     , m_lockLatency()
      , m_lockScope(std::make_unique<FocusScope>(this))
      , m_appsScope(std::make_unique<FocusScope>(this))
 {
@@ -366,39 +374,122 @@ Output *Shell::selectPrimaryOutput(Seat *seat)
     return output;
 }
 
+static uint32_t presentationTime(weston_compositor *c)
+{
+    timespec ts;
+    weston_compositor_read_presentation_clock(c, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// The shell is locked once every output presented a frame showing the lock layer, or
+// after LockDeadline if some of them don't.
 void Shell::lock(const LockCallback &callback)
 {
     if (m_locked) {
         return;
     }
+    if (m_locking) {
+        if (callback) {
+            m_lockCallbacks.push_back(callback);
+        }
+        return;
+    }
 
     emit aboutToLock();
-    if (m_compositor->outputs().empty()) {
-        m_locked = true;
-        emit locked();
-    } else {
-        int *numOuts = new int;
-        *numOuts = m_compositor->outputs().size();
-        for (Output *o: m_compositor->outputs()) {
-            o->lock([this, numOuts, callback]() {
-                if (--*numOuts == 0) {
-                    m_locked = true;
-                    emit locked();
-                    if (callback) {
-                        callback();
-                    }
-                    delete numOuts;
-                }
-            });
-        }
+    m_locking = true;
+    m_lockStart = presentationTime(m_compositor->compositor());
+    m_lockTime = 0;
+    if (callback) {
+        m_lockCallbacks.push_back(callback);
+    }
+
+    m_lockPending = m_compositor->outputs();
+    for (Output *o: m_lockPending) {
+        o->lock([this, o](uint32_t msecs) { lockPresented(o, msecs); });
     }
     for (Seat *s: m_compositor->seats()) {
         s->activate(m_lockScope.get());
     }
+
+    if (m_lockPending.empty()) {
+        finishLock();
+    } else {
+        m_lockDeadline.setRepeat(false);
+        m_lockDeadline.setTimeoutHandler([this]() { finishLock(); });
+        m_lockDeadline.start(LockDeadline);
+    }
+}
+
+void Shell::lockPresented(Output *output, uint32_t msecs)
+{
+    auto it = std::find(m_lockPending.begin(), m_lockPending.end(), output);
+    if (it == m_lockPending.end()) {
+        return;
+    }
+    m_lockPending.erase(it);
+
+    uint32_t time = msecs - m_lockStart;
+    Debug::debug("Lock shown on output {} after {} ms", output->id(), time);
+    m_lockTime = std::max(m_lockTime, time);
+    if (m_lockPending.empty()) {
+        m_lockDeadline.stop();
+        finishLock();
+    }
+}
+
+void Shell::finishLock()
+{
+    if (!m_locking) {
+        return;
+    }
+
+    if (!m_lockPending.empty()) {
+        m_lockTime = presentationTime(m_compositor->compositor()) - m_lockStart;
+        Debug::debug("Lock not shown on {} outputs after {} ms, locking anyway", m_lockPending.size(), m_lockTime);
+        m_lockPending.clear();
+    }
+
+    size_t bucket = 0;
+    while (bucket < m_lockLatency.size() - 1 && m_lockTime >= (1u << bucket)) {
+        ++bucket;
+    }
+    ++m_lockLatency[bucket];
+
+    uint32_t count = 0;
+    for (uint32_t n: m_lockLatency) {
+        count += n;
+    }
+    auto percentile = [&](uint32_t p) {
+        uint32_t seen = 0;
+        for (size_t i = 0; i < m_lockLatency.size(); ++i) {
+            seen += m_lockLatency[i];
+            if (seen * 100 >= count * p) {
+                return 1u << i;
+            }
+        }
+        return 1u << (m_lockLatency.size() - 1);
+    };
+    Debug::debug("Lock shown on all outputs after {} ms, p50 < {} ms, p99 < {} ms over {} locks",
+                 m_lockTime, percentile(50), percentile(99), count);
+
+    m_locking = false;
+    m_locked = true;
+    emit locked();
+    auto callbacks = std::move(m_lockCallbacks);
+    m_lockCallbacks.clear();
+    for (auto &cb: callbacks) {
+        cb();
+    }
 }
 
 void Shell::unlock()
 {
+    if (m_locking) {
+        m_locking = false;
+        m_lockPending.clear();
+        m_lockCallbacks.clear();
+        m_lockDeadline.stop();
+    }
     m_locked = false;
     for (Output *o: m_compositor->outputs()) {
         o->unlock();
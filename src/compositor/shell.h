@@ -23,10 +23,12 @@
 #include <functional>
 #include <vector>
 #include <memory>
+#include <array>
 
 #include "interface.h"
 #include "stringview.h"
 #include "shellsurface.h"
+#include "timer.h"
 
 struct weston_desktop;
 
@@ -130,6 +132,11 @@ private:
     void setAlpha(Seat *s, uint32_t time, PointerAxis axis, double value);
     void initEnvironment();
     void autostartClients();
+    void lockPresented(Output *output, uint32_t msecs);
+    void finishLock();
+
+    // if an output doesn't show the lock in this time, e.g. because it is off, stop waiting
+    static const int LockDeadline = 1000;
 
     Compositor *m_compositor;
     weston_desktop *m_wdesktop;
@@ -144,6 +151,14 @@ private:
     AxisBinding *m_alphaBinding;
     Pager *m_pager;
     bool m_locked;
+    bool m_locking;
+    std::vector<Output *> m_lockPending;
+    std::vector<LockCallback> m_lockCallbacks;
+    uint32_t m_lockStart;
+    uint32_t m_lockTime;
+    Timer m_lockDeadline;
+    // bucket i counts the locks which took less than 2^i ms to show on all outputs
+    std::array<uint32_t, 12> m_lockLatency;
     std::unique_ptr<FocusScope> m_lockScope;
     std::unique_ptr<FocusScope> m_appsScope;
     std::vector<std::pair<std::string, Action>> m_actions;
@@ -398,6 +398,13 @@ void ShellSurface::close()
     }
 }
 
+void ShellSurface::requestClose()
+{
+    if (m_handler) {
+        m_handler.close();
+    }
+}
+
 void ShellSurface::preview(Output *output)
 {
     ShellView *v = viewForOutput(output);
@@ -525,6 +532,10 @@ void ShellSurface::committed(int x, int y)
         return;
     }
 
+    if (pixman_region32_not_empty(&m_surface->surface()->damage)) {
+        emit damaged();
+    }
+
     updateState();
 
     if (m_type == Type::None) {
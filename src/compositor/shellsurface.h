@@ -64,6 +64,7 @@ public:
 
         inline void setSize(int w, int h) { m_if->setSize(w, h); }
         inline QRect geometry() const { return m_if->geometry(); }
+        inline void close() { m_if->close(); }
 
         inline operator bool() const { return m_if.get(); }
 
@@ -73,6 +74,7 @@ public:
             virtual ~AbstractIf() = default;
             virtual void setSize(int w, int h) = 0;
             virtual QRect geometry() const = 0;
+            virtual void close() = 0;
         };
         template<class T>
         struct If : AbstractIf
@@ -80,6 +82,7 @@ public:
             If(T &t) : data(t) {}
             void setSize(int w, int h) override { data.setSize(w, h); }
             QRect geometry() const override { return data.geometry(); }
+            void close() override { data.close(); }
             T data;
         };
         std::unique_ptr<AbstractIf> m_if;
@@ -124,6 +127,8 @@ public:
     bool isMinimized() const { return m_minimized; }
     void restore();
     void close();
+    // asks the client to close this surface, instead of terminating it as close() does
+    void requestClose();
 
     void preview(Output *output);
     void endPreview(Output *output);
@@ -156,6 +161,7 @@ signals:
     void appIdChanged();
     void minimized();
     void restored();
+    void damaged();
 
 private:
     void parentSurfaceDestroyed();
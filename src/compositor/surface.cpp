@@ -17,11 +17,14 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <time.h>
+
 #include <QDebug>
 
 #include "surface.h"
 #include "view.h"
 #include "shellsurface.h"
+#include "westonprivate.h"
 
 namespace Orbital {
 
@@ -122,6 +125,19 @@ void Surface::damage()
     weston_surface_damage(m_surface);
 }
 
+void Surface::sendFrameCallbacks()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint32_t msecs = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+    weston_frame_callback *cb, *cnext;
+    wl_list_for_each_safe(cb, cnext, &m_surface->frame_callback_list, link) {
+        wl_callback_send_done(cb->resource, msecs);
+        wl_resource_destroy(cb->resource);
+    }
+}
+
 Surface *Surface::mainSurface() const
 {
     return Surface::fromSurface(weston_surface_get_main_surface(m_surface));
@@ -117,6 +117,11 @@ public:
 
     void repaint();
     void damage();
+    /**
+     * Send the pending frame callbacks right away, without repainting. Useful for
+     * surfaces that are not on any output, which would otherwise never get them.
+     */
+    void sendFrameCallbacks();
 
     bool setRole(const char *roleName, wl_resource *errorResource, uint32_t errorCode);
     void setRole(const char *roleName);
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pixman.h>
+
+#include "thumbnail.h"
+#include "shellsurface.h"
+#include "surface.h"
+#include "debug.h"
+
+namespace Orbital {
+
+static void scaleImage(pixman_format_code_t srcFormat, const void *src, const QSize &srcSize, int srcStride,
+                       void *dst, const QSize &dstSize, int dstStride)
+{
+    pixman_image_t *srcImage = pixman_image_create_bits(srcFormat, srcSize.width(), srcSize.height(),
+                                                        (uint32_t *)src, srcStride);
+    pixman_image_t *dstImage = pixman_image_create_bits(PIXMAN_a8r8g8b8, dstSize.width(), dstSize.height(),
+                                                        (uint32_t *)dst, dstStride);
+
+    pixman_transform_t transform;
+    pixman_transform_init_scale(&transform,
+                                pixman_double_to_fixed((double)srcSize.width() / (double)dstSize.width()),
+                                pixman_double_to_fixed((double)srcSize.height() / (double)dstSize.height()));
+    pixman_image_set_transform(srcImage, &transform);
+    pixman_image_set_filter(srcImage, PIXMAN_FILTER_GOOD, nullptr, 0);
+
+    pixman_image_composite32(PIXMAN_OP_SRC, srcImage, nullptr, dstImage, 0, 0, 0, 0, 0, 0,
+                             dstSize.width(), dstSize.height());
+
+    pixman_image_unref(srcImage);
+    pixman_image_unref(dstImage);
+}
+
+Thumbnail::Thumbnail()
+         : Interface()
+         , m_refs(0)
+         , m_dirty(true)
+         , m_throttled(false)
+{
+    m_timer.setRepeat(false);
+    m_timer.setTimeoutHandler([this]() { timeout(); });
+}
+
+Thumbnail *Thumbnail::get(ShellSurface *shsurf)
+{
+    Thumbnail *t = shsurf->findInterface<Thumbnail>();
+    if (!t) {
+        t = new Thumbnail;
+        shsurf->addInterface(t);
+    }
+    return t;
+}
+
+void Thumbnail::added()
+{
+    connect(shsurf(), &ShellSurface::damaged, this, &Thumbnail::damaged);
+}
+
+ShellSurface *Thumbnail::shsurf() const
+{
+    return static_cast<ShellSurface *>(object());
+}
+
+void Thumbnail::ref()
+{
+    if (m_refs++ == 0 && m_dirty) {
+        damaged();
+    }
+}
+
+void Thumbnail::deref()
+{
+    --m_refs;
+}
+
+void Thumbnail::copy(void *data, const QSize &size, int stride) const
+{
+    scaleImage(PIXMAN_a8r8g8b8, m_data.data(), m_size, m_size.width() * 4, data, size, stride);
+}
+
+void Thumbnail::damaged()
+{
+    m_dirty = true;
+    if (m_refs == 0 || m_throttled) {
+        return;
+    }
+
+    update();
+    m_throttled = true;
+    m_timer.start(UpdateInterval);
+}
+
+void Thumbnail::timeout()
+{
+    m_throttled = false;
+    if (m_dirty && m_refs > 0) {
+        damaged();
+    }
+}
+
+void Thumbnail::update()
+{
+    Surface *surface = shsurf()->surface();
+    QSize contentSize = surface->contentSize();
+    if (contentSize.isEmpty()) {
+        return;
+    }
+
+    // the full size content is only needed for the time of the downscale, don't keep it around
+    std::vector<uint32_t> content(contentSize.width() * contentSize.height());
+    if (surface->copyContent(content.data(), content.size() * 4, QRect(QPoint(), contentSize)) != 0) {
+        Debug::debug("Failed to copy the content of {} for the thumbnail", surface);
+        return;
+    }
+
+    QSize size = contentSize;
+    if (size.width() > MaxSize || size.height() > MaxSize) {
+        size.scale(MaxSize, MaxSize, Qt::KeepAspectRatio);
+    }
+    m_size = size.expandedTo(QSize(1, 1));
+    m_data.resize(m_size.width() * m_size.height());
+
+    // weston gives us the surface content as RGBA, pixman converts it while scaling
+    scaleImage(PIXMAN_a8b8g8r8, content.data(), contentSize, contentSize.width() * 4,
+               m_data.data(), m_size, m_size.width() * 4);
+    m_dirty = false;
+
+    emit updated();
+}
+
+}
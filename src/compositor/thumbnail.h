@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_THUMBNAIL_H
+#define ORBITAL_THUMBNAIL_H
+
+#include <vector>
+
+#include <QSize>
+
+#include "interface.h"
+#include "timer.h"
+
+namespace Orbital {
+
+class ShellSurface;
+
+/**
+ * A small downscaled snapshot of the content of a shell surface.
+ * The snapshot is refreshed only while someone holds a reference to it,
+ * when the surface commits some damage, and at most once per update interval.
+ */
+class Thumbnail : public Interface
+{
+    Q_OBJECT
+public:
+    static const int MaxSize = 256;
+    static const int UpdateInterval = 1000;
+
+    Thumbnail();
+
+    static Thumbnail *get(ShellSurface *shsurf);
+
+    void ref();
+    void deref();
+
+    bool isValid() const { return !m_data.empty(); }
+    QSize size() const { return m_size; }
+    /**
+     * Copy the snapshot into an ARGB8888 buffer, scaling it to the given size.
+     */
+    void copy(void *data, const QSize &size, int stride) const;
+
+signals:
+    void updated();
+
+protected:
+    void added() override;
+
+private:
+    ShellSurface *shsurf() const;
+    void damaged();
+    void timeout();
+    void update();
+
+    std::vector<uint32_t> m_data;
+    QSize m_size;
+    Timer m_timer;
+    int m_refs;
+    bool m_dirty;
+    bool m_throttled;
+};
+
+}
+
+#endif
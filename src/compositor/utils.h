@@ -95,6 +95,8 @@ public:
     inline void setNotify(const Notify &n) { m_notify = n; }
 
     inline void connect(wl_signal *signal) { wl_signal_add(signal, this); }
+    inline void connect(wl_client *client) { wl_client_add_destroy_listener(client, this); }
+    inline void disconnect() { wl_list_remove(&link); wl_list_init(&link); }
 
 private:
     inline static void fire(wl_listener *listener, void *data) {
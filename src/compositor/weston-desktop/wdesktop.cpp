@@ -100,6 +100,10 @@ public:
         auto geom = weston_desktop_surface_get_geometry(m_wds);
         return QRect(geom.x, geom.y, geom.width, geom.height);
     }
+    void close()
+    {
+        weston_desktop_surface_close(m_wds);
+    }
 
     static DesktopSurface *get(weston_desktop_surface *wds)
     {
@@ -1,5 +1,5 @@
 /*
- * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
  *
  * This file is part of Orbital
  *
@@ -17,30 +17,18 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef CLIBACKEND_H
-#define CLIBACKEND_H
+#ifndef ORBITAL_WESTONPRIVATE_H
+#define ORBITAL_WESTONPRIVATE_H
 
-#include "hardwareservice.h"
+#include <wayland-server.h>
 
-class CliDevice : public Device
-{
-public:
-    CliDevice(const QString &udi);
+// Structs that libweston keeps private but that we need to look into.
+// XXX FIXME They come from compositor.c and must match the libweston version we build
+// against, they should go away once libweston has an API for what we do with them.
 
-    bool umount() override;
-    bool mount() override;
-    bool isMounted() const override;
-
-private:
-};
-
-class CliBackend : public HardwareManager::Backend
-{
-public:
-    static CliBackend *create(HardwareManager *hw);
-
-private:
-    CliBackend(HardwareManager *hw);
+struct weston_frame_callback {
+    struct wl_resource *resource;
+    struct wl_list link;
 };
 
 #endif
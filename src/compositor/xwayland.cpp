@@ -130,6 +130,7 @@ XWayland::XWayland(Shell *shell)
         : Interface(shell)
         , m_shell(shell)
         , m_process(nullptr)
+        , m_client(nullptr)
 {
     weston_compositor *compositor = shell->compositor()->m_compositor;
 
@@ -37,6 +37,8 @@ public:
     XWayland(Shell *shell);
     ~XWayland();
 
+    wl_client *client() const { return m_client; }
+
 private:
     static pid_t spawnXserver(void *ud, const char *xdpy, int abstractFd, int unixFd);
     class Process;
@@ -24,7 +24,7 @@ import QtQuick.Controls.Styles 1.2
 Rectangle {
     id: root
     color: "white"
-    signal selected(string exec, string line)
+    signal selected(string key, string exec, string line)
 
     function reset() {
         text.text = ""
@@ -47,7 +47,9 @@ Rectangle {
             matcherModel.expression = text.text;
         }
         onAccepted: {
-            root.selected(view.currentItem.text, text.text)
+            // run what was typed if nothing matched it
+            var item = view.currentItem;
+            root.selected(item ? item.itemKey : "", item ? item.execLine : text.text.split(" ")[0], text.text)
         }
 
         Keys.onDownPressed: {
@@ -57,13 +59,13 @@ Rectangle {
             event.accepted = true;
         }
         Keys.onUpPressed: {
-            if (view.currentIndex < view.count - 2) {
+            if (view.currentIndex < view.count - 1) {
                 view.currentIndex++;
             }
             event.accepted = true;
         }
         Keys.onEscapePressed: {
-            root.selected("", "")
+            root.selected("", "", "")
             event.accepted = true;
         }
         Keys.onPressed: {
@@ -71,7 +73,7 @@ Rectangle {
                 view.currentIndex = 0;
                 event.accepted = true;
             } else if (event.key == Qt.Key_End) {
-                view.currentIndex = view.count - 2;
+                view.currentIndex = view.count - 1;
                 event.accepted = true;
             } else if (event.key == Qt.Key_U && event.modifiers == Qt.ControlModifier) {
                 text.text = "";
@@ -90,6 +92,8 @@ Rectangle {
         spacing: 5
         clip: true
         delegate: Text {
+            readonly property string itemKey: model.key
+            readonly property string execLine: model.exec
             text: display ? display : ""
             height: root.height
             verticalAlignment: Text.AlignVCenter
@@ -0,0 +1,391 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QLocale>
+#include <QSet>
+#include <QDebug>
+
+#include "launcherindex.h"
+
+// bump this when changing the format of the index
+static const quint32 IndexVersion = 2;
+
+static qint64 modificationTime(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+static QDataStream &operator<<(QDataStream &stream, const LauncherItem &item)
+{
+    return stream << item.key << item.name << item.exec << item.terms;
+}
+
+static QDataStream &operator>>(QDataStream &stream, LauncherItem &item)
+{
+    return stream >> item.key >> item.name >> item.exec >> item.terms;
+}
+
+// the desktop files escape some characters in the values, e.g. \s for a space
+static QString unescape(const QString &value)
+{
+    QString out;
+    out.reserve(value.length());
+    for (int i = 0; i < value.length(); ++i) {
+        QChar c = value.at(i);
+        if (c == QLatin1Char('\\') && i + 1 < value.length()) {
+            switch (value.at(++i).unicode()) {
+                case 's': c = QLatin1Char(' '); break;
+                case 'n': c = QLatin1Char('\n'); break;
+                case 't': c = QLatin1Char('\t'); break;
+                case 'r': c = QLatin1Char('\r'); break;
+                default: c = value.at(i); break;
+            }
+        }
+        out.append(c);
+    }
+    return out;
+}
+
+// drop the field codes like %f or %U, there will be no files or urls to pass
+static QString stripFieldCodes(const QString &exec)
+{
+    QString out;
+    for (int i = 0; i < exec.length(); ++i) {
+        if (exec.at(i) == QLatin1Char('%') && i + 1 < exec.length()) {
+            if (exec.at(++i) == QLatin1Char('%')) {
+                out.append(QLatin1Char('%'));
+            }
+            continue;
+        }
+        out.append(exec.at(i));
+    }
+    return out.simplified();
+}
+
+static QString localizedValue(const QHash<QString, QString> &values, const QString &key, const QString &locale)
+{
+    QString value = values.value(QStringLiteral("%1[%2]").arg(key, locale));
+    if (value.isEmpty()) {
+        value = values.value(QStringLiteral("%1[%2]").arg(key, locale.section(QLatin1Char('_'), 0, 0)));
+    }
+    if (value.isEmpty()) {
+        value = values.value(key);
+    }
+    return value;
+}
+
+static bool readDesktopFile(const QString &path, const QString &id, const QString &locale, LauncherItem &item)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QHash<QString, QString> values;
+    bool inGroup = false;
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+        if (line.startsWith(QLatin1Char('['))) {
+            if (inGroup) {
+                break;
+            }
+            inGroup = line == QLatin1String("[Desktop Entry]");
+            continue;
+        }
+        int eq = line.indexOf(QLatin1Char('='));
+        if (inGroup && eq > 0) {
+            values.insert(line.left(eq).trimmed(), unescape(line.mid(eq + 1).trimmed()));
+        }
+    }
+
+    if (values.value(QStringLiteral("Type")) != QLatin1String("Application") ||
+        values.value(QStringLiteral("NoDisplay")) == QLatin1String("true") ||
+        values.value(QStringLiteral("Hidden")) == QLatin1String("true")) {
+        return false;
+    }
+
+    item.key = id;
+    item.name = localizedValue(values, QStringLiteral("Name"), locale);
+    item.exec = stripFieldCodes(values.value(QStringLiteral("Exec")));
+    if (item.name.isEmpty() || item.exec.isEmpty()) {
+        return false;
+    }
+
+    item.terms.clear();
+    QString genericName = localizedValue(values, QStringLiteral("GenericName"), locale);
+    if (!genericName.isEmpty()) {
+        item.terms << genericName;
+    }
+    // the untranslated name is useful too, the user may know the application by it
+    QString name = values.value(QStringLiteral("Name"));
+    if (name != item.name) {
+        item.terms << name;
+    }
+    item.terms << localizedValue(values, QStringLiteral("Keywords"), locale).split(QLatin1Char(';'), QString::SkipEmptyParts);
+    return true;
+}
+
+LauncherIndex::LauncherIndex()
+             : m_file(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/orbital/launcher.index"))
+             , m_locale(QLocale::system().name())
+             , m_dirty(false)
+{
+}
+
+LauncherIndex::~LauncherIndex()
+{
+    if (m_dirty) {
+        save();
+    }
+}
+
+bool LauncherIndex::scanExecutables(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.isDir()) {
+        return removeDirectory(path);
+    }
+
+    // adding or removing an executable changes the mtime of the directory
+    qint64 mtime = modificationTime(info);
+    auto it = m_directories.constFind(path);
+    if (it != m_directories.constEnd() && it->mtime == mtime) {
+        return false;
+    }
+
+    Directory directory = { mtime, QVector<Entry>(), QStringList() };
+    if (DIR *dir = opendir(qPrintable(path))) {
+        int fd = dirfd(dir);
+        while (dirent *entry = readdir(dir)) {
+            if (entry->d_type == DT_DIR) {
+                continue;
+            }
+
+            struct stat st;
+            if (fstatat(fd, entry->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode) ||
+                faccessat(fd, entry->d_name, X_OK, 0) != 0) {
+                continue;
+            }
+            QString name = QString::fromLocal8Bit(entry->d_name);
+            directory.entries << Entry{ name, 0, LauncherItem{ name, name, name, QStringList() } };
+        }
+        closedir(dir);
+    }
+
+    m_directories.insert(path, directory);
+    m_dirty = true;
+    return true;
+}
+
+bool LauncherIndex::scanApplications(const QString &path)
+{
+    return scanApplications(path, QString());
+}
+
+// the id of a desktop file in a subdirectory has the subdirectory in it,
+// e.g. kde4/foo.desktop is kde4-foo.desktop
+bool LauncherIndex::scanApplications(const QString &path, const QString &idPrefix)
+{
+    QDir dir(path);
+    QFileInfo info(path);
+    if (!info.isDir()) {
+        return removeDirectory(path);
+    }
+
+    bool changed = false;
+    qint64 mtime = modificationTime(info);
+    auto it = m_directories.constFind(path);
+    bool cached = it != m_directories.constEnd();
+    if (!cached || it->mtime != mtime) {
+        QHash<QString, const Entry *> oldEntries;
+        if (cached) {
+            for (const Entry &e: it->entries) {
+                oldEntries.insert(e.fileName, &e);
+            }
+        }
+
+        // only parse again the files that changed
+        Directory directory = { mtime, QVector<Entry>(), QStringList() };
+        foreach (const QFileInfo &file, dir.entryInfoList(QStringList() << QStringLiteral("*.desktop"), QDir::Files)) {
+            Entry entry = { file.fileName(), modificationTime(file), LauncherItem() };
+            const Entry *oldEntry = oldEntries.value(entry.fileName);
+            if (oldEntry && oldEntry->mtime == entry.mtime) {
+                entry.item = oldEntry->item;
+            } else if (!readDesktopFile(file.filePath(), idPrefix + entry.fileName, m_locale, entry.item)) {
+                // remember the hidden ones too, so they are not parsed every time
+                entry.item = LauncherItem();
+            }
+            directory.entries << entry;
+        }
+        // don't follow the symlinks, they may make a loop
+        foreach (const QFileInfo &subdir, dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            directory.subdirs << subdir.filePath();
+        }
+        QStringList oldSubdirs = cached ? it->subdirs : QStringList();
+
+        m_directories.insert(path, directory);
+        for (const QString &subdir: oldSubdirs) {
+            if (!directory.subdirs.contains(subdir)) {
+                removeDirectory(subdir);
+            }
+        }
+        m_dirty = true;
+        changed = true;
+    }
+
+    // the subdirectories change without touching the mtime of this one
+    for (const QString &subdir: m_directories.value(path).subdirs) {
+        changed |= scanApplications(subdir, idPrefix + QFileInfo(subdir).fileName() + QLatin1Char('-'));
+    }
+    return changed;
+}
+
+bool LauncherIndex::removeDirectory(const QString &path)
+{
+    auto it = m_directories.find(path);
+    if (it == m_directories.end()) {
+        return false;
+    }
+
+    QStringList subdirs = it->subdirs;
+    m_directories.erase(it);
+    for (const QString &subdir: subdirs) {
+        removeDirectory(subdir);
+    }
+    m_dirty = true;
+    return true;
+}
+
+QStringList LauncherIndex::subdirectories(const QString &path) const
+{
+    QStringList dirs;
+    for (const QString &subdir: m_directories.value(path).subdirs) {
+        dirs << subdir << subdirectories(subdir);
+    }
+    return dirs;
+}
+
+QVector<LauncherItem> LauncherIndex::items(const QStringList &dirs) const
+{
+    QVector<LauncherItem> items;
+    QSet<QString> keys;
+    for (const QString &dir: dirs) {
+        addItems(dir, QString(), keys, items);
+    }
+    return items;
+}
+
+void LauncherIndex::addItems(const QString &path, const QString &idPrefix, QSet<QString> &keys, QVector<LauncherItem> &items) const
+{
+    const Directory directory = m_directories.value(path);
+    for (const Entry &entry: directory.entries) {
+        // a hidden desktop file in a directory hides the ones in the following ones
+        QString key = entry.item.key.isEmpty() ? idPrefix + entry.fileName : entry.item.key;
+        if (keys.contains(key)) {
+            continue;
+        }
+        keys.insert(key);
+        if (!entry.item.key.isEmpty()) {
+            items << entry.item;
+        }
+    }
+    for (const QString &subdir: directory.subdirs) {
+        addItems(subdir, idPrefix + QFileInfo(subdir).fileName() + QLatin1Char('-'), keys, items);
+    }
+}
+
+bool LauncherIndex::load()
+{
+    QFile file(m_file);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 version;
+    QString locale;
+    stream >> version;
+    if (version != IndexVersion) {
+        return false;
+    }
+    // the names of the applications depend on the locale
+    stream >> locale;
+    if (locale != m_locale) {
+        return false;
+    }
+
+    quint32 numDirectories;
+    stream >> numDirectories;
+    for (quint32 i = 0; i < numDirectories && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Directory directory;
+        quint32 numEntries;
+        stream >> path >> directory.mtime >> directory.subdirs >> numEntries;
+        for (quint32 j = 0; j < numEntries && stream.status() == QDataStream::Ok; ++j) {
+            Entry entry;
+            stream >> entry.fileName >> entry.mtime >> entry.item;
+            directory.entries << entry;
+        }
+        m_directories.insert(path, directory);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Corrupted index" << m_file << ", ignoring it.";
+        m_directories.clear();
+        return false;
+    }
+    return true;
+}
+
+void LauncherIndex::save()
+{
+    QDir().mkpath(QFileInfo(m_file).absolutePath());
+    QSaveFile file(m_file);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write the index" << m_file << ":" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << IndexVersion << m_locale << (quint32)m_directories.count();
+    for (auto it = m_directories.constBegin(); it != m_directories.constEnd(); ++it) {
+        stream << it.key() << it->mtime << it->subdirs << (quint32)it->entries.count();
+        for (const Entry &entry: it->entries) {
+            stream << entry.fileName << entry.mtime << entry.item;
+        }
+    }
+    if (file.commit()) {
+        m_dirty = false;
+    }
+}
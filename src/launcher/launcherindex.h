@@ -0,0 +1,100 @@
+/*
+ * Copyright 2017 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_LAUNCHER_INDEX_H
+#define ORBITAL_LAUNCHER_INDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QMetaType>
+
+struct LauncherItem {
+    // the executable name, or the desktop file id for applications
+    QString key;
+    QString name;
+    // the command line to run, without the desktop file field codes
+    QString exec;
+    // other strings to match, like the generic name and the keywords of applications
+    QStringList terms;
+};
+
+Q_DECLARE_METATYPE(LauncherItem)
+
+/*
+ * An on-disk index of the executables in PATH and of the applications' desktop files,
+ * so that the launcher has its results right away at startup. A directory is only listed
+ * again when its modification time changes, and a desktop file is only parsed again when
+ * its own modification time changes.
+ */
+class LauncherIndex
+{
+public:
+    LauncherIndex();
+    ~LauncherIndex();
+
+    /**
+     * Load the index saved by a previous run. Returns false if there was none.
+     */
+    bool load();
+    void save();
+
+    /**
+     * Bring the directory up to date, returning true if its content changed.
+     * The applications directories are scanned together with their subdirectories.
+     */
+    bool scanExecutables(const QString &path);
+    bool scanApplications(const QString &path);
+
+    /**
+     * All the subdirectories found under the directory, recursively.
+     */
+    QStringList subdirectories(const QString &path) const;
+
+    /**
+     * All the items of the directories, the ones in the first directories
+     * hiding the ones with the same key in the following ones.
+     */
+    QVector<LauncherItem> items(const QStringList &dirs) const;
+
+private:
+    struct Entry {
+        QString fileName;
+        qint64 mtime;
+        LauncherItem item;
+    };
+    struct Directory {
+        qint64 mtime;
+        QVector<Entry> entries;
+        QStringList subdirs;
+    };
+
+    bool scanApplications(const QString &path, const QString &idPrefix);
+    bool removeDirectory(const QString &path);
+    void addItems(const QString &path, const QString &idPrefix, QSet<QString> &keys, QVector<LauncherItem> &items) const;
+
+    QString m_file;
+    QString m_locale;
+    QHash<QString, Directory> m_directories;
+    bool m_dirty;
+};
+
+#endif
@@ -32,6 +32,37 @@
 #include "matchermodel.h"
 #include "wayland-desktop-shell-client-protocol.h"
 
+// splits a desktop file Exec line, where the arguments may be quoted
+static QStringList splitCommand(const QString &command)
+{
+    QStringList args;
+    QString arg;
+    bool quoted = false;
+    bool hasArg = false;
+    for (int i = 0; i < command.length(); ++i) {
+        QChar c = command.at(i);
+        if (quoted && c == QLatin1Char('\\') && i + 1 < command.length()) {
+            arg.append(command.at(++i));
+        } else if (c == QLatin1Char('"')) {
+            quoted = !quoted;
+            hasArg = true;
+        } else if (!quoted && c == QLatin1Char(' ')) {
+            if (hasArg) {
+                args << arg;
+                arg.clear();
+                hasArg = false;
+            }
+        } else {
+            arg.append(c);
+            hasArg = true;
+        }
+    }
+    if (hasArg) {
+        args << arg;
+    }
+    return args;
+}
+
 static const QEvent::Type ConfigureEventType = (QEvent::Type)QEvent::registerEventType();
 
 class Launcher;
@@ -119,7 +150,7 @@ public:
         m_window->rootContext()->setContextProperty(QStringLiteral("availableHeight"), 0.);
         m_window->rootContext()->setContextProperty(QStringLiteral("matcherModel"), m_matcher);
         m_window->setSource(QUrl(QStringLiteral("qrc:///launcher.qml")));
-        connect(m_window->rootObject(), SIGNAL(selected(QString, QString)), this, SLOT(run(QString, QString)));
+        connect(m_window->rootObject(), SIGNAL(selected(QString, QString, QString)), this, SLOT(run(QString, QString, QString)));
         m_window->show();
         wl_surface *wlSurface = static_cast<wl_surface *>(QGuiApplication::platformNativeInterface()->nativeResourceForWindow("surface", m_window));
         m_surface = orbital_launcher_get_launcher_surface(m_launcher, wlSurface);
@@ -148,7 +179,7 @@ public:
     orbital_settings *settings() const { return m_settings; }
 
 private slots:
-    void run(const QString &exec, const QString &fullLine)
+    void run(const QString &key, const QString &exec, const QString &fullLine)
     {
         orbital_launcher_surface_done(m_surface);
         QStringList args = fullLine.split(QLatin1Char(' '));
@@ -165,12 +196,13 @@ private slots:
             m_commands.value(command)->run(args);
         } else {
             args.removeFirst();
-            if (QProcess::startDetached(exec, args)) {
-                QString fullCommand = exec;
-                foreach (const QString &arg, args) {
-                    fullCommand += QStringLiteral(" %1").arg(arg);
-                }
-                m_matcher->addInHistory(fullCommand);
+            QStringList command = splitCommand(exec);
+            if (command.isEmpty()) {
+                return;
+            }
+            QString program = command.takeFirst();
+            if (QProcess::startDetached(program, command + args)) {
+                m_matcher->addInHistory(key.isEmpty() ? program : key);
             }
         }
     }
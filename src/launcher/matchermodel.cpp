@@ -18,47 +18,188 @@
  */
 
 #include <stdlib.h>
-#include <dirent.h>
-#include <unistd.h>
+
+#include <algorithm>
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QStandardPaths>
 #include <QFileSystemWatcher>
+#include <QThread>
 
 #include "matchermodel.h"
 
+/*
+ * Lives in the worker thread and keeps the index up to date, sending
+ * the whole list of items when something changed.
+ */
+class IndexScanner : public QObject
+{
+    Q_OBJECT
+public:
+    IndexScanner(const QStringList &executableDirs, const QStringList &applicationDirs)
+        : m_executableDirs(executableDirs)
+        , m_applicationDirs(applicationDirs)
+    {
+    }
+
+    Q_INVOKABLE void load()
+    {
+        // give the saved results right away, then check what changed in the meantime
+        if (m_index.load()) {
+            emit indexChanged(m_index.items(m_executableDirs + m_applicationDirs));
+        }
+        scan(m_executableDirs + m_applicationDirs);
+    }
+
+    Q_INVOKABLE void scan(const QStringList &dirs)
+    {
+        // a change in a subdirectory of the applications is scanned from its top directory
+        QStringList applicationDirs;
+        QStringList executableDirs;
+        foreach (const QString &dir, dirs) {
+            QString root = applicationRoot(dir);
+            if (root.isEmpty()) {
+                executableDirs << dir;
+            } else if (!applicationDirs.contains(root)) {
+                applicationDirs << root;
+            }
+        }
+
+        bool changed = false;
+        foreach (const QString &dir, applicationDirs) {
+            changed |= m_index.scanApplications(dir);
+        }
+        foreach (const QString &dir, executableDirs) {
+            changed |= m_index.scanExecutables(dir);
+        }
+
+        if (changed) {
+            emit indexChanged(m_index.items(m_executableDirs + m_applicationDirs));
+            m_index.save();
+        }
+
+        // also after the first scan, when the index was loaded unchanged
+        QStringList subdirs;
+        foreach (const QString &dir, m_applicationDirs) {
+            subdirs << m_index.subdirectories(dir);
+        }
+        if (subdirs != m_subdirs) {
+            m_subdirs = subdirs;
+            emit subdirectoriesChanged(subdirs);
+        }
+    }
+
+signals:
+    void indexChanged(const QVector<LauncherItem> &items);
+    void subdirectoriesChanged(const QStringList &dirs);
+
+private:
+    QString applicationRoot(const QString &dir) const
+    {
+        foreach (const QString &root, m_applicationDirs) {
+            if (dir == root || dir.startsWith(root + QLatin1Char('/'))) {
+                return root;
+            }
+        }
+        return QString();
+    }
+
+    QStringList m_executableDirs;
+    QStringList m_applicationDirs;
+    QStringList m_subdirs;
+    LauncherIndex m_index;
+};
+
 MatcherModel::MatcherModel()
             : QAbstractListModel()
+            , m_historyFile(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/orbital/launcher-history"))
             , m_watcher(new QFileSystemWatcher(this))
+            , m_scannerThread(new QThread(this))
 {
-    QString path = QString::fromUtf8(qgetenv("PATH"));
-    foreach (const QString &p, path.split(QLatin1Char(':'))) {
-        m_watcher->addPath(p);
-    }
+    qRegisterMetaType<QVector<LauncherItem>>();
 
-    buildItemsList();
-    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &MatcherModel::buildItemsList);
+    QStringList executableDirs = QString::fromUtf8(qgetenv("PATH")).split(QLatin1Char(':'), QString::SkipEmptyParts);
+    QStringList applicationDirs = QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation);
+    m_watcher->addPaths(executableDirs + applicationDirs);
+
+    loadHistory();
+
+    m_scanner = new IndexScanner(executableDirs, applicationDirs);
+    m_scanner->moveToThread(m_scannerThread);
+    connect(m_scannerThread, &QThread::finished, m_scanner, &QObject::deleteLater);
+    connect(m_scanner, &IndexScanner::indexChanged, this, &MatcherModel::indexChanged);
+    connect(m_scanner, &IndexScanner::subdirectoriesChanged, this, &MatcherModel::watchDirectories);
+    m_scannerThread->start();
+    QMetaObject::invokeMethod(m_scanner, "load");
+
+    // installing a package changes a directory many times in a row, scan it once at the end
+    m_scanTimer.setSingleShot(true);
+    m_scanTimer.setInterval(200);
+    connect(&m_scanTimer, &QTimer::timeout, this, &MatcherModel::scanDirectories);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &dir) {
+        m_dirtyDirectories.insert(dir);
+        m_scanTimer.start();
+    });
 }
 
-void MatcherModel::buildItemsList()
+MatcherModel::~MatcherModel()
 {
-    m_items.clear();
-    foreach (const QString &p, m_watcher->directories()) {
-        QDir dir(p);
-        foreach (const QFileInfo &f, dir.entryInfoList(QDir::Files)) {
-            if (!f.isExecutable()) {
-                continue;
-            }
+    m_scannerThread->quit();
+    m_scannerThread->wait();
+}
+
+void MatcherModel::scanDirectories()
+{
+    QStringList dirs = m_dirtyDirectories.toList();
+    m_dirtyDirectories.clear();
+    QMetaObject::invokeMethod(m_scanner, "scan", Q_ARG(QStringList, dirs));
+}
+
+void MatcherModel::watchDirectories(const QStringList &dirs)
+{
+    // the removed directories stop being watched by themselves
+    QStringList watched = m_watcher->directories();
+    QStringList added;
+    foreach (const QString &dir, dirs) {
+        if (!watched.contains(dir)) {
+            added << dir;
+        }
+    }
+    if (!added.isEmpty()) {
+        m_watcher->addPaths(added);
+    }
+}
 
-            m_items << f.fileName();
+void MatcherModel::indexChanged(const QVector<LauncherItem> &items)
+{
+    m_items.clear();
+    m_itemsByKey.clear();
+    for (const LauncherItem &item: items) {
+        addItem(item);
+    }
+    // what was launched but is not in the index, e.g. with a full path
+    for (auto it = m_history.constBegin(); it != m_history.constEnd(); ++it) {
+        if (!m_itemsByKey.contains(it.key()) && !it.key().endsWith(QLatin1String(".desktop"))) {
+            addItem(LauncherItem{ it.key(), it.key(), it.key(), QStringList() });
         }
     }
-    m_items.sort();
-    m_items.removeDuplicates();
 
+    m_candidatesExpression = QString();
     matchExpression();
 }
 
+void MatcherModel::addItem(const LauncherItem &item)
+{
+    m_itemsByKey.insert(item.key, m_items.count());
+    m_items << item;
+}
+
 QString MatcherModel::expression() const
 {
     return m_expression;
@@ -92,46 +233,267 @@ int MatcherModel::rowCount(const QModelIndex &parent) const
 
 QVariant MatcherModel::data(const QModelIndex &index, int role) const
 {
-    return m_matches.at(index.row());
+    const LauncherItem &item = m_matches.at(index.row());
+    switch (role) {
+        case KeyRole: return item.key;
+        case ExecRole: return item.exec;
+        default: return item.name;
+    }
 }
 
-void MatcherModel::matchExpression()
+QHash<int, QByteArray> MatcherModel::roleNames() const
 {
-    beginResetModel();
-    m_matches.clear();
-    endResetModel();
+    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+    roles.insert(KeyRole, "key");
+    roles.insert(ExecRole, "exec");
+    return roles;
+}
 
-    QStringList matches;
+// -1 if the expression is not a subsequence of the string. Exact and prefix matches
+// come first, then the subsequences, with bonuses for consecutive characters and for
+// characters at the start of a word.
+int MatcherModel::score(const QString &string, const QString &expr)
+{
+    if (expr.isEmpty()) {
+        return 0;
+    }
+    if (string == expr) {
+        return 1000;
+    }
+    if (string.startsWith(expr, Qt::CaseInsensitive)) {
+        return qMax(500, 800 - (string.length() - expr.length()));
+    }
+
+    int score = 400;
+    int last = -1;
+    for (QChar c: expr) {
+        c = c.toLower();
+        int pos = last + 1;
+        while (pos < string.length() && string.at(pos).toLower() != c) {
+            ++pos;
+        }
+        if (pos == string.length()) {
+            return -1;
+        }
+
+        if (pos == last + 1) {
+            score += 5;
+        } else {
+            score -= pos - last - 1;
+        }
+        if (pos == 0 || !string.at(pos - 1).isLetterOrNumber()) {
+            score += 10;
+        }
+        last = pos;
+    }
+    return qBound(0, score - string.length() / 4, 499);
+}
+
+// the name counts more than the generic name and the keywords
+int MatcherModel::score(const LauncherItem &item, const QString &expr)
+{
+    int best = score(item.name, expr);
+    for (const QString &term: item.terms) {
+        int s = score(term, expr);
+        if (s >= 0) {
+            best = qMax(best, qMax(0, s - 100));
+        }
+    }
+    return best;
+}
+
+int MatcherModel::frecency(const QString &key) const
+{
+    auto it = m_history.constFind(key);
+    if (it == m_history.constEnd()) {
+        return 0;
+    }
+
+    qint64 age = QDateTime::currentMSecsSinceEpoch() / 1000 - it->lastUsed;
+    int weight = age < 3600 * 24 ? 40 : age < 3600 * 24 * 7 ? 20 : age < 3600 * 24 * 30 ? 10 : 5;
+    return qMin(300, it->count * weight);
+}
+
+void MatcherModel::matchExpression()
+{
+    QVector<LauncherItem> matches;
 
     if (m_expression == m_commandPrefix) {
-        matches = m_commands;
+        for (const QString &entry: m_commands) {
+            matches << LauncherItem{ entry, entry, entry, QStringList() };
+        }
     } else if (m_expression.startsWith(m_commandPrefix)) {
         QString command = m_expression.mid(m_commandPrefix.length());
         foreach (const QString &entry, m_commands) {
             if (entry == command) {
-                matches.prepend(entry);
+                matches.prepend(LauncherItem{ entry, entry, entry, QStringList() });
             } else if (entry.startsWith(command)) {
-                matches.append(entry);
+                matches.append(LauncherItem{ entry, entry, entry, QStringList() });
             }
         }
     } else {
-        foreach (const QString &entry, m_items) {
-            if (entry == m_expression) {
-                matches.prepend(entry);
-            } else if (entry.startsWith(m_expression)) {
-                matches.append(entry);
+        // the matches of a longer expression can only be among the matches of a shorter one
+        QVector<int> candidates;
+        if (!m_candidatesExpression.isNull() && m_expression.startsWith(m_candidatesExpression)) {
+            candidates = m_candidates;
+        } else {
+            candidates.reserve(m_items.count());
+            for (int i = 0; i < m_items.count(); ++i) {
+                candidates << i;
+            }
+        }
+
+        QVector<QPair<int, int>> scored;
+        m_candidates.clear();
+        for (int i: candidates) {
+            const LauncherItem &item = m_items.at(i);
+            int s = score(item, m_expression);
+            if (s >= 0) {
+                m_candidates << i;
+                scored.append(qMakePair(s + frecency(item.key), i));
+            }
+        }
+        m_candidatesExpression = m_expression;
+
+        int count = qMin(scored.count(), (int)MaxMatches);
+        std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                          [this](const QPair<int, int> &a, const QPair<int, int> &b) {
+            return a.first > b.first || (a.first == b.first && m_items.at(a.second).name < m_items.at(b.second).name);
+        });
+        for (int i = 0; i < count; ++i) {
+            matches << m_items.at(scored.at(i).second);
+        }
+    }
+
+    setMatches(matches);
+}
+
+// Turns the current matches into the new ones with row removals, moves and
+// insertions, so that the view doesn't need to recreate all of its delegates.
+void MatcherModel::setMatches(const QVector<LauncherItem> &matches)
+{
+    QSet<QString> newKeys;
+    for (const LauncherItem &item: matches) {
+        newKeys.insert(item.key);
+    }
+    for (int i = m_matches.count() - 1; i >= 0; --i) {
+        if (newKeys.contains(m_matches.at(i).key)) {
+            continue;
+        }
+        int first = i;
+        while (first > 0 && !newKeys.contains(m_matches.at(first - 1).key)) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), first, i);
+        m_matches.erase(m_matches.begin() + first, m_matches.begin() + i + 1);
+        endRemoveRows();
+        i = first;
+    }
+
+    QSet<QString> oldKeys;
+    for (const LauncherItem &item: m_matches) {
+        oldKeys.insert(item.key);
+    }
+    for (int i = 0; i < matches.count(); ++i) {
+        const LauncherItem &item = matches.at(i);
+        if (i < m_matches.count() && m_matches.at(i).key == item.key) {
+            continue;
+        }
+
+        if (oldKeys.contains(item.key)) {
+            int from = i + 1;
+            while (m_matches.at(from).key != item.key) {
+                ++from;
             }
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), i);
+            m_matches.move(from, i);
+            endMoveRows();
+            continue;
         }
+
+        int last = i;
+        while (last + 1 < matches.count() && !oldKeys.contains(matches.at(last + 1).key)) {
+            ++last;
+        }
+        beginInsertRows(QModelIndex(), i, last);
+        for (int j = i; j <= last; ++j) {
+            m_matches.insert(j, matches.at(j));
+        }
+        endInsertRows();
+        i = last;
     }
-    beginInsertRows(QModelIndex(), 0, matches.count());
-    m_matches = matches;
-    endInsertRows();
 }
 
-void MatcherModel::addInHistory(const QString &command)
+void MatcherModel::addInHistory(const QString &key)
 {
-    if (!command.isEmpty()) {
-        m_items.removeOne(command);
-        m_items.prepend(command);
+    if (key.isEmpty()) {
+        return;
     }
+
+    HistoryEntry &entry = m_history[key];
+    entry.count++;
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch() / 1000;
+    if (!m_itemsByKey.contains(key)) {
+        addItem(LauncherItem{ key, key, key, QStringList() });
+    }
+    m_candidatesExpression = QString();
+    saveHistory();
 }
+
+// the history is a line per item, with the launch count, the last launch time and the key
+void MatcherModel::loadHistory()
+{
+    QFile file(m_historyFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+        QString key = line.section(QLatin1Char(' '), 2);
+        if (!key.isEmpty()) {
+            HistoryEntry &entry = m_history[key];
+            entry.count = line.section(QLatin1Char(' '), 0, 0).toInt();
+            entry.lastUsed = line.section(QLatin1Char(' '), 1, 1).toLongLong();
+        }
+    }
+}
+
+void MatcherModel::saveHistory()
+{
+    // forget the oldest entries
+    if (m_history.count() > MaxHistory) {
+        QVector<qint64> times;
+        for (const HistoryEntry &entry: m_history) {
+            times << entry.lastUsed;
+        }
+        std::nth_element(times.begin(), times.begin() + (times.count() - MaxHistory), times.end());
+        qint64 oldest = times.at(times.count() - MaxHistory);
+        for (auto it = m_history.begin(); it != m_history.end();) {
+            if (it->lastUsed < oldest) {
+                it = m_history.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    QDir().mkpath(QFileInfo(m_historyFile).absolutePath());
+    QSaveFile file(m_historyFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Cannot write the launcher history" << m_historyFile << ":" << file.errorString();
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    for (auto it = m_history.constBegin(); it != m_history.constEnd(); ++it) {
+        stream << it->count << ' ' << it->lastUsed << ' ' << it.key() << '\n';
+    }
+    stream.flush();
+    file.commit();
+}
+
+#include "matchermodel.moc"
@@ -21,17 +21,37 @@
 #define ORBITAL_LAUNCHER_MATCHER_MODEL_H
 
 #include <QAbstractListModel>
-#include <QLinkedList>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
 
+#include "launcherindex.h"
 
 class QFileSystemWatcher;
+class QThread;
+class IndexScanner;
 
+/*
+ * Matches the executables in PATH and the applications with a fuzzy subsequence
+ * match, ranking them by how well they match and by how often and how recently
+ * they were launched. The index is kept up to date in a worker thread, and typing
+ * more characters only looks into the previous matches.
+ */
 class MatcherModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(QString expression READ expression WRITE setExpression)
 public:
+    static const int MaxMatches = 100;
+    static const int MaxHistory = 500;
+
+    enum Roles {
+        KeyRole = Qt::UserRole + 1,
+        ExecRole
+    };
+
     MatcherModel();
+    ~MatcherModel();
 
     void setCommandPrefix(const QString &prefix);
     void addCommand(const QString &command);
@@ -41,19 +61,48 @@ public:
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
 
-    void addInHistory(const QString &command);
+    /**
+     * The key is the one of the launched item, or the executable if it was
+     * not in the index.
+     */
+    void addInHistory(const QString &key);
 
 private:
-    void buildItemsList();
+    struct HistoryEntry {
+        int count = 0;
+        qint64 lastUsed = 0;
+    };
+
+    void scanDirectories();
+    void indexChanged(const QVector<LauncherItem> &items);
+    void watchDirectories(const QStringList &dirs);
+    void addItem(const LauncherItem &item);
     void matchExpression();
+    void setMatches(const QVector<LauncherItem> &matches);
+    int frecency(const QString &key) const;
+    static int score(const LauncherItem &item, const QString &expr);
+    static int score(const QString &string, const QString &expr);
+    void loadHistory();
+    void saveHistory();
 
     QString m_expression;
-    QStringList m_items;
-    QStringList m_matches;
+    QVector<LauncherItem> m_items;
+    QHash<QString, int> m_itemsByKey;
+    // the items matching m_candidatesExpression, the matches of a longer expression are among these
+    QVector<int> m_candidates;
+    QString m_candidatesExpression;
+    QVector<LauncherItem> m_matches;
     QString m_commandPrefix;
     QStringList m_commands;
+    QHash<QString, HistoryEntry> m_history;
+    QString m_historyFile;
     QFileSystemWatcher *m_watcher;
+    QSet<QString> m_dirtyDirectories;
+    QTimer m_scanTimer;
+    IndexScanner *m_scanner;
+    QThread *m_scannerThread;
 };
 
 #endif
@@ -0,0 +1,120 @@
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "layoutsolver.h"
+
+class TstLayout : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testIncrement_data();
+    void testIncrement();
+    void testMatchesIterative();
+    void benchmark_data();
+    void benchmark();
+};
+
+// the old layout algorithm, which shares the space left again every time an item stops growing
+static std::vector<qreal> iterativeSizes(const std::vector<qreal> &headrooms, qreal spaceLeft)
+{
+    std::vector<qreal> sizes(headrooms.size(), 0);
+    std::vector<bool> growing(headrooms.size(), true);
+    int num = headrooms.size();
+    bool again = true;
+    while (again && spaceLeft > 0 && num > 0) {
+        again = false;
+        qreal share = spaceLeft / num;
+        for (size_t i = 0; i < headrooms.size(); ++i) {
+            if (!growing[i]) {
+                continue;
+            }
+            qreal grow = qMin(share, headrooms[i] - sizes[i]);
+            sizes[i] += grow;
+            spaceLeft -= grow;
+            if (sizes[i] >= headrooms[i]) {
+                growing[i] = false;
+                --num;
+                again = true;
+            }
+        }
+    }
+    return sizes;
+}
+
+static std::vector<qreal> randomHeadrooms(int count)
+{
+    std::vector<qreal> headrooms;
+    headrooms.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        headrooms.push_back(qrand() % 200);
+    }
+    return headrooms;
+}
+
+void TstLayout::testIncrement_data()
+{
+    QTest::addColumn<QVector<qreal>>("headrooms");
+    QTest::addColumn<qreal>("spaceLeft");
+    QTest::addColumn<qreal>("increment");
+
+    QTest::newRow("no items") << QVector<qreal>() << qreal(100) << qreal(0);
+    QTest::newRow("no space") << QVector<qreal>({ 10, 20 }) << qreal(0) << qreal(0);
+    QTest::newRow("negative space") << QVector<qreal>({ 10, 20 }) << qreal(-10) << qreal(0);
+    QTest::newRow("equal shares") << QVector<qreal>({ 100, 100 }) << qreal(100) << qreal(50);
+    QTest::newRow("one capped") << QVector<qreal>({ 10, 100, 100 }) << qreal(110) << qreal(50);
+    QTest::newRow("all capped") << QVector<qreal>({ 10, 20 }) << qreal(100) << qreal(20);
+    QTest::newRow("no headroom") << QVector<qreal>({ 0, 0, 30 }) << qreal(60) << qreal(30);
+}
+
+void TstLayout::testIncrement()
+{
+    QFETCH(QVector<qreal>, headrooms);
+    QFETCH(qreal, spaceLeft);
+    QFETCH(qreal, increment);
+
+    std::vector<qreal> h = headrooms.toStdVector();
+    QCOMPARE(layoutIncrement(h, spaceLeft), increment);
+}
+
+void TstLayout::testMatchesIterative()
+{
+    qsrand(1);
+    for (int run = 0; run < 100; ++run) {
+        std::vector<qreal> headrooms = randomHeadrooms(1 + qrand() % 50);
+        qreal spaceLeft = qrand() % 5000;
+
+        std::vector<qreal> expected = iterativeSizes(headrooms, spaceLeft);
+        std::vector<qreal> sorted = headrooms;
+        qreal increment = layoutIncrement(sorted, spaceLeft);
+        for (size_t i = 0; i < headrooms.size(); ++i) {
+            QVERIFY(qAbs(qMin(headrooms[i], increment) - expected[i]) < 0.001);
+        }
+    }
+}
+
+void TstLayout::benchmark_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10 items") << 10;
+    QTest::newRow("50 items") << 50;
+    QTest::newRow("100 items") << 100;
+    QTest::newRow("500 items") << 500;
+}
+
+void TstLayout::benchmark()
+{
+    QFETCH(int, count);
+
+    qsrand(1);
+    const std::vector<qreal> headrooms = randomHeadrooms(count);
+    std::vector<qreal> h;
+    qreal spaceLeft = count * 50;
+    QBENCHMARK {
+        h = headrooms;
+        layoutIncrement(h, spaceLeft);
+    }
+}
+
+QTEST_MAIN(TstLayout)
+#include "tst_layout.moc"
@@ -0,0 +1,276 @@
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <thread>
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "clipboardtransfer.h"
+
+using namespace Orbital;
+
+static const size_t MaxEntrySize = 1 << 20;
+
+class TstClipboardTransfer : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testHash();
+    void testReadChunk();
+    void benchmarkRead_data();
+    void benchmarkRead();
+    void benchmarkForward_data();
+    void benchmarkForward();
+    void benchmarkRelay_data();
+    void benchmarkRelay();
+
+private:
+    void addSizes();
+};
+
+// writes the data to the fd from another thread, like a client sending the selection
+class Feeder
+{
+public:
+    Feeder(const QByteArray &data, int fd)
+        : m_thread([data, fd]() {
+            const char *p = data.constData();
+            ssize_t left = data.size();
+            while (left > 0) {
+                ssize_t len = write(fd, p, left);
+                if (len < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (len <= 0) {
+                    break;
+                }
+                p += len;
+                left -= len;
+            }
+            close(fd);
+        })
+    {
+    }
+    ~Feeder()
+    {
+        m_thread.join();
+    }
+
+private:
+    std::thread m_thread;
+};
+
+// reads everything from the fd from another thread, like a client pasting the selection
+class Drainer
+{
+public:
+    explicit Drainer(int fd)
+        : m_size(0)
+        , m_thread([this, fd]() {
+            char buf[ClipboardTransfer::ChunkSize];
+            ssize_t len;
+            while ((len = read(fd, buf, sizeof(buf))) > 0 || (len < 0 && errno == EINTR)) {
+                m_size += len > 0 ? len : 0;
+            }
+            close(fd);
+        })
+    {
+    }
+
+    size_t wait()
+    {
+        m_thread.join();
+        return m_size;
+    }
+
+private:
+    size_t m_size;
+    std::thread m_thread;
+};
+
+static QByteArray makeData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        data[i] = char(i * 31 + i / 4096);
+    }
+    return data;
+}
+
+static void waitReadable(int fd)
+{
+    pollfd pfd = { fd, POLLIN, 0 };
+    poll(&pfd, 1, -1);
+}
+
+void TstClipboardTransfer::initTestCase()
+{
+    // the history stops reading the big selections, so the feeder may write to a closed pipe
+    signal(SIGPIPE, SIG_IGN);
+}
+
+void TstClipboardTransfer::addSizes()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("64 KiB") << (64 << 10);
+    QTest::newRow("1 MiB") << (1 << 20);
+    QTest::newRow("16 MiB") << (16 << 20);
+    QTest::newRow("64 MiB") << (64 << 20);
+}
+
+void TstClipboardTransfer::testHash()
+{
+    QByteArray data = makeData(1000);
+    uint64_t hash = ClipboardTransfer::HashSeed;
+    hash = ClipboardTransfer::hash(hash, data.constData(), 300);
+    hash = ClipboardTransfer::hash(hash, data.constData() + 300, 700);
+    QCOMPARE(hash, ClipboardTransfer::hash(ClipboardTransfer::HashSeed, data.constData(), data.size()));
+
+    data[500] = data[500] + 1;
+    QVERIFY(hash != ClipboardTransfer::hash(ClipboardTransfer::HashSeed, data.constData(), data.size()));
+}
+
+void TstClipboardTransfer::testReadChunk()
+{
+    QByteArray data = makeData(3 * ClipboardTransfer::ChunkSize + 123);
+    int fds[2];
+    QVERIFY(pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0);
+    fcntl(fds[1], F_SETFL, 0);
+
+    std::string read;
+    uint64_t hash = ClipboardTransfer::HashSeed;
+    ssize_t maxLen = 0;
+    {
+        Feeder feeder(data, fds[1]);
+        while (true) {
+            ssize_t len = ClipboardTransfer::readChunk(fds[0], &read, &hash);
+            if (len < 0 && errno == EAGAIN) {
+                waitReadable(fds[0]);
+                continue;
+            }
+            if (len <= 0) {
+                maxLen = len < 0 ? len : maxLen;
+                break;
+            }
+            maxLen = std::max(maxLen, len);
+        }
+        // don't leave the feeder blocked on a full pipe if reading failed
+        close(fds[0]);
+    }
+
+    QVERIFY(maxLen > 0 && maxLen <= ssize_t(ClipboardTransfer::ChunkSize));
+
+    QCOMPARE(QByteArray(read.data(), read.size()), data);
+    QCOMPARE(hash, ClipboardTransfer::hash(ClipboardTransfer::HashSeed, data.constData(), data.size()));
+}
+
+void TstClipboardTransfer::benchmarkRead_data()
+{
+    addSizes();
+}
+
+// what setting the selection costs the compositor: it reads at most MaxEntrySize and
+// leaves the rest of the bigger selections to their source
+void TstClipboardTransfer::benchmarkRead()
+{
+    QFETCH(int, size);
+    QByteArray data = makeData(size);
+
+    QBENCHMARK {
+        int fds[2];
+        QVERIFY(pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0);
+        fcntl(fds[1], F_SETFL, 0);
+        std::string read;
+        uint64_t hash = ClipboardTransfer::HashSeed;
+        {
+            Feeder feeder(data, fds[1]);
+            while (read.size() <= MaxEntrySize) {
+                ssize_t len = ClipboardTransfer::readChunk(fds[0], &read, &hash);
+                if (len < 0 && errno == EAGAIN) {
+                    waitReadable(fds[0]);
+                    continue;
+                }
+                if (len <= 0) {
+                    break;
+                }
+            }
+            close(fds[0]);
+        }
+        QVERIFY(read.size() == size_t(size) || read.size() > MaxEntrySize);
+    }
+}
+
+void TstClipboardTransfer::benchmarkForward_data()
+{
+    addSizes();
+}
+
+// how a big selection is pasted: the source writes straight to the pasting client
+void TstClipboardTransfer::benchmarkForward()
+{
+    QFETCH(int, size);
+    QByteArray data = makeData(size);
+
+    QBENCHMARK {
+        int fds[2];
+        QVERIFY(pipe2(fds, O_CLOEXEC) == 0);
+        Drainer drainer(fds[0]);
+        {
+            Feeder feeder(data, fds[1]);
+        }
+        QCOMPARE(drainer.wait(), size_t(size));
+    }
+}
+
+void TstClipboardTransfer::benchmarkRelay_data()
+{
+    addSizes();
+}
+
+// what pasting it would cost if the compositor had copied it: read from the source
+// into memory and written again to the pasting client
+void TstClipboardTransfer::benchmarkRelay()
+{
+    QFETCH(int, size);
+    QByteArray data = makeData(size);
+
+    QBENCHMARK {
+        int in[2], out[2];
+        QVERIFY(pipe2(in, O_CLOEXEC) == 0);
+        QVERIFY(pipe2(out, O_CLOEXEC) == 0);
+        Drainer drainer(out[0]);
+        {
+            Feeder feeder(data, in[1]);
+            std::string buffer;
+            uint64_t hash = ClipboardTransfer::HashSeed;
+            while (ClipboardTransfer::readChunk(in[0], &buffer, &hash) > 0) {
+            }
+            close(in[0]);
+
+            const char *p = buffer.data();
+            size_t left = buffer.size();
+            while (left > 0) {
+                ssize_t len = write(out[1], p, left);
+                if (len < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (len <= 0) {
+                    break;
+                }
+                p += len;
+                left -= len;
+            }
+            close(out[1]);
+        }
+        QCOMPARE(drainer.wait(), size_t(size));
+    }
+}
+
+QTEST_MAIN(TstClipboardTransfer)
+#include "tst_clipboardtransfer.moc"